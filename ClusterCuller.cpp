@@ -0,0 +1,185 @@
+#include "ClusterCuller.h"
+#include "Scene.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr uint32_t kCullGroupSize = 64;
+}
+
+ClusterCuller::ClusterCuller(const vk::raii::Device& device,
+                             const vk::raii::PhysicalDevice& physicalDevice,
+                             const vk::raii::CommandPool& commandPool,
+                             const vk::raii::Queue& queue,
+                             const MeshletMesh& mesh,
+                             uint32_t instanceCount,
+                             vk::Buffer uniformBuffer,
+                             vk::DeviceSize uniformSize,
+                             bool drawIndirectCount,
+                             bool multiDrawIndirect,
+                             bool backFaceCulling,
+                             ObjectCache& cache)
+    : clusterCount(static_cast<uint32_t>(mesh.meshlets.size())), instanceCount(instanceCount),
+      maxDraws(clusterCount * instanceCount), drawIndirectCount(drawIndirectCount), multiDrawIndirect(multiDrawIndirect),
+      backFaceCulling(backFaceCulling) {
+
+    if (clusterCount == 0) throw std::runtime_error("cluster culling needs at least one meshlet!");
+
+    std::vector<GpuCluster> clusters(clusterCount);
+    for (uint32_t i = 0; i < clusterCount; i++) {
+        const Meshlet& meshlet = mesh.meshlets[i];
+        const MeshletBounds& bounds = mesh.bounds[i];
+        clusters[i].sphere = glm::vec4(bounds.center, bounds.radius);
+        clusters[i].coneAxisCutoff = glm::vec4(bounds.coneAxis, bounds.coneCutoff);
+        clusters[i].coneApex = glm::vec4(bounds.coneApex, 1.0f);
+        clusters[i].firstIndex = meshlet.triangleOffset * 3;
+        clusters[i].indexCount = meshlet.triangleCount * 3;
+        clusters[i].triangleCount = meshlet.triangleCount;
+        clusters[i].pad = 0;
+    }
+
+    // 1. Static cluster data
+    uploadBuffer(device, physicalDevice, commandPool, queue, clusters.data(), clusters.size() * sizeof(GpuCluster),
+        vk::BufferUsageFlagBits::eStorageBuffer, clusterBuffer, clusterMemory);
+    uploadBuffer(device, physicalDevice, commandPool, queue, mesh.flattenedIndices.data(), mesh.flattenedIndices.size() * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eIndexBuffer, indexBuffer, indexMemory);
+
+    // 2. Per-frame outputs
+    createBuffer(device, physicalDevice, vk::DeviceSize(maxDraws) * sizeof(vk::DrawIndexedIndirectCommand),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, drawBuffer, drawMemory);
+    createBuffer(device, physicalDevice, sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, countBuffer, countMemory);
+    createBuffer(device, physicalDevice, sizeof(GpuStats),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, statsBuffer, statsMemory);
+    statsMapped = static_cast<GpuStats*>(statsMemory.mapMemory(0, sizeof(GpuStats)));
+    memset(statsMapped, 0, sizeof(GpuStats));
+    lastStats.totalClusters = maxDraws;
+
+    createPipeline(device, cache, uniformBuffer, uniformSize);
+}
+
+void ClusterCuller::createPipeline(const vk::raii::Device& device, ObjectCache& cache, vk::Buffer uniformBuffer, vk::DeviceSize uniformSize) {
+    std::array<vk::DescriptorSetLayoutBinding, 5> bindings = {
+        vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(4, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute)
+    };
+    descriptorSetLayout = cache.getDescriptorSetLayout(bindings);
+    descriptorSet = cache.allocatePersistentSet(descriptorSetLayout);
+
+    std::array<vk::DescriptorBufferInfo, 5> bufferInfos = {
+        vk::DescriptorBufferInfo(uniformBuffer, 0, uniformSize),
+        vk::DescriptorBufferInfo(*clusterBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*drawBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*countBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*statsBuffer, 0, VK_WHOLE_SIZE)
+    };
+    std::array<vk::WriteDescriptorSet, 5> writes{};
+    for (uint32_t i = 0; i < writes.size(); i++) {
+        writes[i].dstSet = descriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = i == 0 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    device.updateDescriptorSets(writes, nullptr);
+
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullParams));
+    pipelineLayout = cache.getPipelineLayout(descriptorSetLayout, pushConstantRange);
+
+    auto code = readShaderFile("shaders/meshlet_cull.spv");
+    vk::raii::ShaderModule module(device, vk::ShaderModuleCreateInfo({}, code.size(), reinterpret_cast<const uint32_t*>(code.data())));
+
+    // The uniform block's model array is sized by the instance count
+    vk::SpecializationMapEntry specEntry(0, 0, sizeof(uint32_t));
+    vk::SpecializationInfo specInfo(1, &specEntry, sizeof(uint32_t), &instanceCount);
+
+    vk::PipelineShaderStageCreateInfo stage({}, vk::ShaderStageFlagBits::eCompute, *module, "main", &specInfo);
+    vk::ComputePipelineCreateInfo pipelineInfo({}, stage, pipelineLayout);
+    pipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+}
+
+void ClusterCuller::readStats() {
+    lastStats.visibleClusters = statsMapped->visibleClusters;
+    lastStats.totalTriangles = statsMapped->totalTriangles;
+    lastStats.frustumCulledTriangles = statsMapped->frustumCulledTriangles;
+    lastStats.coneCulledTriangles = statsMapped->coneCulledTriangles;
+}
+
+void ClusterCuller::recordCull(const vk::raii::CommandBuffer& commandBuffer, const glm::mat4& viewProj, const glm::vec3& cameraPosition,
+                               FrameCapture* capture) {
+    CullParams params{};
+    extractFrustumPlanes(viewProj, params.frustumPlanes);
+    params.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+    params.clusterCount = clusterCount;
+    params.instanceCount = instanceCount;
+    params.coneCulling = backFaceCulling ? 1 : 0;
+
+    // Without a count buffer the unused tail of the draw buffer must hold zero-sized draws
+    if (!drawIndirectCount) {
+        commandBuffer.fillBuffer(*drawBuffer, 0, VK_WHOLE_SIZE, 0);
+        if (capture) capture->fillBuffer(*drawBuffer, 0, VK_WHOLE_SIZE, 0);
+    }
+    commandBuffer.fillBuffer(*countBuffer, 0, VK_WHOLE_SIZE, 0);
+    commandBuffer.fillBuffer(*statsBuffer, 0, VK_WHOLE_SIZE, 0);
+
+    vk::MemoryBarrier clearBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, clearBarrier, {}, {});
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, 0, descriptorSet, nullptr);
+    commandBuffer.pushConstants<CullParams>(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, params);
+
+    uint32_t groupCount = (maxDraws + kCullGroupSize - 1) / kCullGroupSize;
+    commandBuffer.dispatch(groupCount, 1, 1);
+
+    vk::MemoryBarrier cullBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eHostRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eHost, {}, cullBarrier, {}, {});
+
+    if (capture) {
+        capture->fillBuffer(*countBuffer, 0, VK_WHOLE_SIZE, 0);
+        capture->fillBuffer(*statsBuffer, 0, VK_WHOLE_SIZE, 0);
+        capture->memoryBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+            clearBarrier.srcAccessMask, clearBarrier.dstAccessMask);
+        capture->bindPipeline(*pipeline, vk::PipelineBindPoint::eCompute);
+        capture->bindDescriptorSet(pipelineLayout, 0, descriptorSet, vk::PipelineBindPoint::eCompute);
+        capture->pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, &params, sizeof(params));
+        capture->dispatch(groupCount, 1, 1);
+        capture->memoryBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eHost,
+            cullBarrier.srcAccessMask, cullBarrier.dstAccessMask);
+    }
+}
+
+void ClusterCuller::recordDraw(const vk::raii::CommandBuffer& commandBuffer, FrameCapture* capture) const {
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+
+    if (drawIndirectCount) {
+        commandBuffer.drawIndexedIndirectCount(*drawBuffer, 0, *countBuffer, 0, maxDraws, stride);
+        if (capture) capture->drawIndexedIndirect(*drawBuffer, 0, *countBuffer, 0, maxDraws, stride);
+    } else if (multiDrawIndirect) {
+        commandBuffer.drawIndexedIndirect(*drawBuffer, 0, maxDraws, stride);
+        if (capture) capture->drawIndexedIndirect(*drawBuffer, 0, nullptr, 0, maxDraws, stride);
+    } else {
+        for (uint32_t i = 0; i < maxDraws; i++) {
+            commandBuffer.drawIndexedIndirect(*drawBuffer, vk::DeviceSize(i) * stride, 1, stride);
+            if (capture) capture->drawIndexedIndirect(*drawBuffer, vk::DeviceSize(i) * stride, nullptr, 0, 1, stride);
+        }
+    }
+}
+
+void ClusterCuller::registerCaptureResources(CaptureResources& resources) const {
+    resources.pipelines.push_back(*pipeline);
+    resources.pipelineLayouts.push_back(pipelineLayout);
+    resources.descriptorSets.push_back(descriptorSet);
+    for (vk::Buffer buffer : {*indexBuffer, *drawBuffer, *countBuffer, *statsBuffer}) {
+        resources.buffers.push_back(buffer);
+        resources.mappedBuffers.push_back(nullptr);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include <glm/glm.hpp>
+
+#include "FrameCapture.h"
+#include "Meshlet.h"
+#include "ObjectCache.h"
+
+struct ClusterCullStats {
+    uint32_t totalClusters = 0;      // meshlets x instances
+    uint32_t visibleClusters = 0;
+    uint64_t totalTriangles = 0;
+    uint64_t frustumCulledTriangles = 0;
+    uint64_t coneCulledTriangles = 0;
+};
+
+// GPU per-cluster culling for one meshlet mesh drawn `instanceCount` times.
+//
+// A compute pass tests every (meshlet, instance) pair against the view frustum and, when the
+// graphics pipeline culls back faces (`backFaceCulling`), the meshlet's normal cone, and appends a VkDrawIndexedIndirectCommand for each survivor.
+// The draw reads the meshlet's range of MeshletMesh::flattenedIndices, so it runs on the
+// regular vertex pipeline and needs no mesh shader support. Compacted draws are issued
+// with drawIndexedIndirectCount when available, otherwise the draw buffer is zeroed each
+// frame and submitted with multi-draw indirect (or one indirect draw per slot).
+class ClusterCuller {
+public:
+    ClusterCuller(const vk::raii::Device& device,
+                  const vk::raii::PhysicalDevice& physicalDevice,
+                  const vk::raii::CommandPool& commandPool,
+                  const vk::raii::Queue& queue,
+                  const MeshletMesh& mesh,
+                  uint32_t instanceCount,
+                  vk::Buffer uniformBuffer,
+                  vk::DeviceSize uniformSize,
+                  bool drawIndirectCount,
+                  bool multiDrawIndirect,
+                  bool backFaceCulling,
+                  ObjectCache& cache);
+
+    const vk::raii::Buffer& getIndexBuffer() const { return indexBuffer; }
+
+    // Call once the previous frame's fence has signalled, before recording the next cull
+    void readStats();
+    const ClusterCullStats& getStats() const { return lastStats; }
+
+    // Records the culling dispatch. Must be outside a render pass, after the uniforms are written.
+    void recordCull(const vk::raii::CommandBuffer& commandBuffer, const glm::mat4& viewProj, const glm::vec3& cameraPosition,
+                    FrameCapture* capture);
+    // Records the compacted draws. Expects the graphics pipeline, vertex buffer, index buffer
+    // (getIndexBuffer()) and descriptor sets to be bound already.
+    void recordDraw(const vk::raii::CommandBuffer& commandBuffer, FrameCapture* capture) const;
+
+    void registerCaptureResources(CaptureResources& resources) const;
+
+private:
+    // std430 mirror of `Cluster` in shaders/meshlet_cull.comp
+    struct GpuCluster {
+        glm::vec4 sphere;          // xyz centre, w radius
+        glm::vec4 coneAxisCutoff;  // xyz axis, w cutoff
+        glm::vec4 coneApex;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t triangleCount;
+        uint32_t pad;
+    };
+
+    // Mirror of `CullParams` in shaders/meshlet_cull.comp
+    struct CullParams {
+        glm::vec4 frustumPlanes[6];
+        glm::vec4 cameraPosition;
+        uint32_t clusterCount;
+        uint32_t instanceCount;
+        uint32_t coneCulling;
+    };
+
+    // Mirror of `Stats` in shaders/meshlet_cull.comp
+    struct GpuStats {
+        uint32_t visibleClusters;
+        uint32_t frustumCulledTriangles;
+        uint32_t coneCulledTriangles;
+        uint32_t totalTriangles;
+    };
+
+    uint32_t clusterCount;
+    uint32_t instanceCount;
+    uint32_t maxDraws;
+    bool drawIndirectCount;
+    bool multiDrawIndirect;
+    bool backFaceCulling;  // cone culling only matches what the rasterizer would drop then
+
+    vk::raii::Buffer clusterBuffer = nullptr;
+    vk::raii::DeviceMemory clusterMemory = nullptr;
+    vk::raii::Buffer indexBuffer = nullptr;
+    vk::raii::DeviceMemory indexMemory = nullptr;
+    vk::raii::Buffer drawBuffer = nullptr;
+    vk::raii::DeviceMemory drawMemory = nullptr;
+    vk::raii::Buffer countBuffer = nullptr;
+    vk::raii::DeviceMemory countMemory = nullptr;
+    vk::raii::Buffer statsBuffer = nullptr;
+    vk::raii::DeviceMemory statsMemory = nullptr;
+    GpuStats* statsMapped = nullptr;
+    ClusterCullStats lastStats;
+
+    // Layouts and the set are owned by the ObjectCache
+    vk::DescriptorSetLayout descriptorSetLayout;
+    vk::DescriptorSet descriptorSet;
+    vk::PipelineLayout pipelineLayout;
+    vk::raii::Pipeline pipeline = nullptr;
+
+    void createPipeline(const vk::raii::Device& device, ObjectCache& cache, vk::Buffer uniformBuffer, vk::DeviceSize uniformSize);
+};
@@ -0,0 +1,447 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr char kCaptureMagic[4] = {'V', 'K', 'C', 'P'};
+    // 2 added PushConstants, 3 bind points, fill, barrier, dispatch and indirect draw ops, 4 config flags
+    constexpr uint32_t kCaptureVersion = 4;
+    constexpr uint32_t kNoBuffer = 0xFFFFFFFF;
+
+    // Bounds-checked reader over one frame's payload
+    class StreamReader {
+    public:
+        explicit StreamReader(const std::vector<uint8_t>& data) : data(data) {}
+
+        bool done() const { return cursor >= data.size(); }
+
+        template <typename T>
+        T get() {
+            T value;
+            read(&value, sizeof(T));
+            return value;
+        }
+
+        const uint8_t* skip(size_t size) {
+            if (cursor + size > data.size()) throw std::runtime_error("truncated capture frame!");
+            const uint8_t* ptr = data.data() + cursor;
+            cursor += size;
+            return ptr;
+        }
+
+        void read(void* dst, size_t size) { memcpy(dst, skip(size), size); }
+
+    private:
+        const std::vector<uint8_t>& data;
+        size_t cursor = 0;
+    };
+
+    template <typename T>
+    const T& lookup(const std::vector<T>& table, uint32_t index) {
+        if (index >= table.size()) throw std::runtime_error("capture references an unknown object!");
+        return table[index];
+    }
+
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[index];
+    }
+}
+
+// --- FrameCapture ---
+
+FrameCapture::FrameCapture(const std::string& path, const CaptureResources& resources, uint32_t configFlags, uint32_t frameLimit)
+    : file(path, std::ios::binary | std::ios::trunc), resources(resources), frameLimit(frameLimit) {
+    if (!file.is_open()) throw std::runtime_error("failed to open capture file: " + path);
+
+    file.write(kCaptureMagic, sizeof(kCaptureMagic));
+    file.write(reinterpret_cast<const char*>(&kCaptureVersion), sizeof(kCaptureVersion));
+    file.write(reinterpret_cast<const char*>(&configFlags), sizeof(configFlags));
+    if (!file) throw std::runtime_error("failed to write capture header: " + path);
+}
+
+void FrameCapture::beginFrame() {
+    if (!active) return;
+    frameData.clear();
+    inFrame = true;
+}
+
+void FrameCapture::endFrame() {
+    if (!active || !inFrame) return;
+    inFrame = false;
+
+    uint32_t size = static_cast<uint32_t>(frameData.size());
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(frameData.data()), size);
+    if (!file) throw std::runtime_error("failed to write capture frame!");
+
+    if (frameLimit != 0 && ++framesWritten >= frameLimit) {
+        file.close();
+        active = false;
+    }
+}
+
+template <typename T>
+uint32_t FrameCapture::indexOf(const std::vector<T>& table, T handle) const {
+    auto it = std::find(table.begin(), table.end(), handle);
+    if (it == table.end()) throw std::runtime_error("captured object was not registered in CaptureResources!");
+    return static_cast<uint32_t>(it - table.begin());
+}
+
+void FrameCapture::beginRenderPass(vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent,
+                                   const vk::ClearValue* clearValues, uint32_t clearValueCount) {
+    if (!inFrame) return;
+    put(CaptureOp::BeginRenderPass);
+    put(indexOf(resources.renderPasses, renderPass));
+    put(indexOf(resources.framebuffers, framebuffer));
+    put(extent.width);
+    put(extent.height);
+    put(clearValueCount);
+    for (uint32_t i = 0; i < clearValueCount; i++) put(clearValues[i]);
+}
+
+void FrameCapture::endRenderPass() {
+    if (!inFrame) return;
+    put(CaptureOp::EndRenderPass);
+}
+
+void FrameCapture::bindPipeline(vk::Pipeline pipeline, vk::PipelineBindPoint bindPoint) {
+    if (!inFrame) return;
+    put(CaptureOp::BindPipeline);
+    put(bindPoint);
+    put(indexOf(resources.pipelines, pipeline));
+}
+
+void FrameCapture::bindVertexBuffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset) {
+    if (!inFrame) return;
+    put(CaptureOp::BindVertexBuffer);
+    put(binding);
+    put(indexOf(resources.buffers, buffer));
+    put(offset);
+}
+
+void FrameCapture::bindIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType) {
+    if (!inFrame) return;
+    put(CaptureOp::BindIndexBuffer);
+    put(indexOf(resources.buffers, buffer));
+    put(offset);
+    put(indexType);
+}
+
+void FrameCapture::bindDescriptorSet(vk::PipelineLayout layout, uint32_t firstSet, vk::DescriptorSet set, vk::PipelineBindPoint bindPoint) {
+    if (!inFrame) return;
+    put(CaptureOp::BindDescriptorSet);
+    put(bindPoint);
+    put(indexOf(resources.pipelineLayouts, layout));
+    put(firstSet);
+    put(indexOf(resources.descriptorSets, set));
+}
+
+void FrameCapture::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    if (!inFrame) return;
+    put(CaptureOp::DrawIndexed);
+    put(indexCount);
+    put(instanceCount);
+    put(firstIndex);
+    put(vertexOffset);
+    put(firstInstance);
+}
+
+void FrameCapture::updateUniform(vk::Buffer buffer, vk::DeviceSize offset, const void* data, uint32_t size) {
+    if (!inFrame) return;
+    put(CaptureOp::UpdateUniform);
+    put(indexOf(resources.buffers, buffer));
+    put(offset);
+    put(size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    frameData.insert(frameData.end(), bytes, bytes + size);
+}
+
+void FrameCapture::pushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, const void* data, uint32_t size) {
+    if (!inFrame) return;
+    put(CaptureOp::PushConstants);
+    put(indexOf(resources.pipelineLayouts, layout));
+    put(static_cast<VkShaderStageFlags>(stages));
+    put(offset);
+    put(size);
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    frameData.insert(frameData.end(), bytes, bytes + size);
+}
+
+void FrameCapture::fillBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize size, uint32_t data) {
+    if (!inFrame) return;
+    put(CaptureOp::FillBuffer);
+    put(indexOf(resources.buffers, buffer));
+    put(offset);
+    put(size);
+    put(data);
+}
+
+void FrameCapture::memoryBarrier(vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess) {
+    if (!inFrame) return;
+    put(CaptureOp::MemoryBarrier);
+    put(static_cast<VkPipelineStageFlags>(srcStage));
+    put(static_cast<VkPipelineStageFlags>(dstStage));
+    put(static_cast<VkAccessFlags>(srcAccess));
+    put(static_cast<VkAccessFlags>(dstAccess));
+}
+
+void FrameCapture::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    if (!inFrame) return;
+    put(CaptureOp::Dispatch);
+    put(groupCountX);
+    put(groupCountY);
+    put(groupCountZ);
+}
+
+void FrameCapture::drawIndexedIndirect(vk::Buffer buffer, vk::DeviceSize offset, vk::Buffer countBuffer, vk::DeviceSize countOffset,
+                                       uint32_t maxDrawCount, uint32_t stride) {
+    if (!inFrame) return;
+    put(CaptureOp::DrawIndexedIndirect);
+    put(indexOf(resources.buffers, buffer));
+    put(offset);
+    put(countBuffer ? indexOf(resources.buffers, countBuffer) : kNoBuffer);
+    put(countOffset);
+    put(maxDrawCount);
+    put(stride);
+}
+
+// --- FrameReplayer ---
+
+FrameReplayer::FrameReplayer(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("failed to open capture file: " + path);
+
+    char magic[4];
+    uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&configFlags), sizeof(configFlags));
+    if (!file || memcmp(magic, kCaptureMagic, sizeof(magic)) != 0 || version != kCaptureVersion) {
+        throw std::runtime_error("not a supported capture file: " + path);
+    }
+
+    uint32_t size = 0;
+    while (file.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+        std::vector<uint8_t> frame(size);
+        if (!file.read(reinterpret_cast<char*>(frame.data()), size)) {
+            throw std::runtime_error("truncated capture file: " + path);
+        }
+        frames.push_back(std::move(frame));
+    }
+}
+
+void FrameReplayer::record(const vk::raii::CommandBuffer& commandBuffer, const std::vector<uint8_t>& frame,
+                           const CaptureResources& resources) const {
+    StreamReader reader(frame);
+    std::vector<vk::ClearValue> clearValues;
+
+    while (!reader.done()) {
+        switch (reader.get<CaptureOp>()) {
+        case CaptureOp::BeginRenderPass: {
+            vk::RenderPass renderPass = lookup(resources.renderPasses, reader.get<uint32_t>());
+            vk::Framebuffer framebuffer = lookup(resources.framebuffers, reader.get<uint32_t>());
+            vk::Extent2D extent;
+            extent.width = reader.get<uint32_t>();
+            extent.height = reader.get<uint32_t>();
+            clearValues.resize(reader.get<uint32_t>());
+            for (auto& clearValue : clearValues) clearValue = reader.get<vk::ClearValue>();
+
+            vk::RenderPassBeginInfo renderPassInfo(renderPass, framebuffer, vk::Rect2D({0, 0}, extent), static_cast<uint32_t>(clearValues.size()), clearValues.data());
+            commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+            break;
+        }
+        case CaptureOp::EndRenderPass:
+            commandBuffer.endRenderPass();
+            break;
+        case CaptureOp::BindPipeline: {
+            vk::PipelineBindPoint bindPoint = reader.get<vk::PipelineBindPoint>();
+            commandBuffer.bindPipeline(bindPoint, lookup(resources.pipelines, reader.get<uint32_t>()));
+            break;
+        }
+        case CaptureOp::BindVertexBuffer: {
+            uint32_t binding = reader.get<uint32_t>();
+            vk::Buffer buffer = lookup(resources.buffers, reader.get<uint32_t>());
+            vk::DeviceSize offset = reader.get<vk::DeviceSize>();
+            commandBuffer.bindVertexBuffers(binding, buffer, offset);
+            break;
+        }
+        case CaptureOp::BindIndexBuffer: {
+            vk::Buffer buffer = lookup(resources.buffers, reader.get<uint32_t>());
+            vk::DeviceSize offset = reader.get<vk::DeviceSize>();
+            commandBuffer.bindIndexBuffer(buffer, offset, reader.get<vk::IndexType>());
+            break;
+        }
+        case CaptureOp::BindDescriptorSet: {
+            vk::PipelineBindPoint bindPoint = reader.get<vk::PipelineBindPoint>();
+            vk::PipelineLayout layout = lookup(resources.pipelineLayouts, reader.get<uint32_t>());
+            uint32_t firstSet = reader.get<uint32_t>();
+            vk::DescriptorSet set = lookup(resources.descriptorSets, reader.get<uint32_t>());
+            commandBuffer.bindDescriptorSets(bindPoint, layout, firstSet, set, nullptr);
+            break;
+        }
+        case CaptureOp::DrawIndexed: {
+            uint32_t indexCount = reader.get<uint32_t>();
+            uint32_t instanceCount = reader.get<uint32_t>();
+            uint32_t firstIndex = reader.get<uint32_t>();
+            int32_t vertexOffset = reader.get<int32_t>();
+            uint32_t firstInstance = reader.get<uint32_t>();
+            commandBuffer.drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+            break;
+        }
+        case CaptureOp::UpdateUniform: {
+            uint32_t bufferIndex = reader.get<uint32_t>();
+            vk::DeviceSize offset = reader.get<vk::DeviceSize>();
+            uint32_t size = reader.get<uint32_t>();
+            const uint8_t* data = reader.skip(size);
+
+            // The previous frame has retired by now, so the mapped memory is safe to overwrite
+            void* mapped = lookup(resources.mappedBuffers, bufferIndex);
+            if (!mapped) throw std::runtime_error("capture updates a buffer that is not host visible!");
+            memcpy(static_cast<uint8_t*>(mapped) + offset, data, size);
+            break;
+        }
+        case CaptureOp::PushConstants: {
+            vk::PipelineLayout layout = lookup(resources.pipelineLayouts, reader.get<uint32_t>());
+            vk::ShaderStageFlags stages(reader.get<VkShaderStageFlags>());
+            uint32_t offset = reader.get<uint32_t>();
+            uint32_t size = reader.get<uint32_t>();
+            const uint8_t* data = reader.skip(size);
+            commandBuffer.pushConstants<uint8_t>(layout, stages, offset, vk::ArrayProxy<const uint8_t>(size, data));
+            break;
+        }
+        case CaptureOp::FillBuffer: {
+            vk::Buffer buffer = lookup(resources.buffers, reader.get<uint32_t>());
+            vk::DeviceSize offset = reader.get<vk::DeviceSize>();
+            vk::DeviceSize size = reader.get<vk::DeviceSize>();
+            commandBuffer.fillBuffer(buffer, offset, size, reader.get<uint32_t>());
+            break;
+        }
+        case CaptureOp::MemoryBarrier: {
+            vk::PipelineStageFlags srcStage(reader.get<VkPipelineStageFlags>());
+            vk::PipelineStageFlags dstStage(reader.get<VkPipelineStageFlags>());
+            vk::AccessFlags srcAccess(reader.get<VkAccessFlags>());
+            vk::AccessFlags dstAccess(reader.get<VkAccessFlags>());
+            commandBuffer.pipelineBarrier(srcStage, dstStage, {}, vk::MemoryBarrier(srcAccess, dstAccess), {}, {});
+            break;
+        }
+        case CaptureOp::Dispatch: {
+            uint32_t x = reader.get<uint32_t>();
+            uint32_t y = reader.get<uint32_t>();
+            commandBuffer.dispatch(x, y, reader.get<uint32_t>());
+            break;
+        }
+        case CaptureOp::DrawIndexedIndirect: {
+            vk::Buffer buffer = lookup(resources.buffers, reader.get<uint32_t>());
+            vk::DeviceSize offset = reader.get<vk::DeviceSize>();
+            uint32_t countIndex = reader.get<uint32_t>();
+            vk::DeviceSize countOffset = reader.get<vk::DeviceSize>();
+            uint32_t maxDrawCount = reader.get<uint32_t>();
+            uint32_t stride = reader.get<uint32_t>();
+            if (countIndex != kNoBuffer) {
+                commandBuffer.drawIndexedIndirectCount(buffer, offset, lookup(resources.buffers, countIndex), countOffset, maxDrawCount, stride);
+            } else {
+                commandBuffer.drawIndexedIndirect(buffer, offset, maxDrawCount, stride);
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error("unknown op in capture stream!");
+        }
+    }
+}
+
+std::vector<ReplayFrameStats> FrameReplayer::run(const vk::raii::Device& device,
+                                                 const vk::raii::CommandPool& commandPool,
+                                                 const vk::raii::Queue& queue,
+                                                 const CaptureResources& resources,
+                                                 float timestampPeriod,
+                                                 uint32_t timestampValidBits,
+                                                 uint32_t loops) const {
+    vk::CommandBufferAllocateInfo allocInfo(*commandPool, vk::CommandBufferLevel::ePrimary, 1);
+    vk::raii::CommandBuffers cb(device, allocInfo);
+    vk::raii::CommandBuffer commandBuffer = std::move(cb[0]);
+
+    vk::raii::Fence fence(device, vk::FenceCreateInfo{});
+
+    bool gpuTiming = timestampPeriod > 0.0f && timestampValidBits > 0;
+    // Bits above timestampValidBits are undefined, and the counter wraps at that width
+    uint64_t timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+    vk::raii::QueryPool queryPool = nullptr;
+    if (gpuTiming) {
+        queryPool = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, 2));
+    }
+
+    std::vector<ReplayFrameStats> stats;
+    stats.reserve(frames.size() * loops);
+
+    for (uint32_t loop = 0; loop < loops; loop++) {
+        for (const auto& frame : frames) {
+            ReplayFrameStats frameStats;
+
+            // CPU cost covers re-encoding the frame and handing it to the queue
+            auto cpuStart = std::chrono::high_resolution_clock::now();
+
+            commandBuffer.reset();
+            commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+            if (gpuTiming) {
+                commandBuffer.resetQueryPool(*queryPool, 0, 2);
+                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
+            }
+            record(commandBuffer, frame, resources);
+            if (gpuTiming) {
+                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
+            }
+            commandBuffer.end();
+
+            vk::SubmitInfo submitInfo({}, {}, *commandBuffer, {});
+            queue.submit(submitInfo, *fence);
+
+            auto cpuEnd = std::chrono::high_resolution_clock::now();
+            frameStats.cpuSubmitMs = std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count();
+
+            (void)device.waitForFences(*fence, VK_TRUE, UINT64_MAX);
+            device.resetFences(*fence);
+
+            if (gpuTiming) {
+                auto [result, timestamps] = queryPool.getResults<uint64_t>(0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t),
+                    vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+                if (result == vk::Result::eSuccess) {
+                    uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask;
+                    frameStats.gpuMs = ticks * timestampPeriod / 1.0e6;
+                }
+            }
+
+            stats.push_back(frameStats);
+        }
+    }
+
+    return stats;
+}
+
+void FrameReplayer::report(const std::vector<ReplayFrameStats>& stats, std::ostream& csv, std::ostream& summary) {
+    std::vector<double> cpu, gpu;
+    csv << "frame,cpu_submit_ms,gpu_ms\n";
+    for (size_t i = 0; i < stats.size(); i++) {
+        csv << i << "," << stats[i].cpuSubmitMs << "," << stats[i].gpuMs << "\n";
+        cpu.push_back(stats[i].cpuSubmitMs);
+        gpu.push_back(stats[i].gpuMs);
+    }
+
+    auto line = [&](const char* name, const std::vector<double>& values) {
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        double avg = values.empty() ? 0.0 : sum / values.size();
+        summary << name << ": min " << percentile(values, 0.0) << " ms, avg " << avg
+                << " ms, p95 " << percentile(values, 0.95) << " ms, max " << percentile(values, 1.0) << " ms" << std::endl;
+    };
+
+    summary << "Replayed " << stats.size() << " frames" << std::endl;
+    line("CPU submit", cpu);
+    line("GPU", gpu);
+}
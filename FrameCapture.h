@@ -0,0 +1,131 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Opcodes of the capture stream. Every op is a one byte tag followed by its fixed-size
+// payload (UpdateUniform and PushConstants additionally carry `size` bytes of data).
+// Values are stored in host byte order, so captures only move between little-endian hosts.
+enum class CaptureOp : uint8_t {
+    BeginRenderPass = 1,
+    EndRenderPass = 2,
+    BindPipeline = 3,
+    BindVertexBuffer = 4,
+    BindIndexBuffer = 5,
+    BindDescriptorSet = 6,
+    DrawIndexed = 7,
+    UpdateUniform = 8,
+    PushConstants = 9,
+    FillBuffer = 10,
+    MemoryBarrier = 11,
+    Dispatch = 12,
+    DrawIndexedIndirect = 13,
+};
+
+// Objects referenced by a capture. Streams store indices into these tables instead of
+// raw handles, so the application must fill them in the same order when capturing and
+// when replaying. `mappedBuffers` runs parallel to `buffers` (nullptr if not host visible).
+struct CaptureResources {
+    std::vector<vk::RenderPass> renderPasses;
+    std::vector<vk::Framebuffer> framebuffers;
+    std::vector<vk::Pipeline> pipelines;
+    std::vector<vk::PipelineLayout> pipelineLayouts;
+    std::vector<vk::Buffer> buffers;
+    std::vector<void*> mappedBuffers;
+    std::vector<vk::DescriptorSet> descriptorSets;
+};
+
+// Records the commands issued by drawFrame() into a compact binary file. `configFlags` are
+// stored in the header for the application to check at replay; the capture doesn't interpret them.
+class FrameCapture {
+public:
+    FrameCapture(const std::string& path, const CaptureResources& resources, uint32_t configFlags, uint32_t frameLimit);
+
+    bool isActive() const { return active; }
+
+    void beginFrame();
+    void endFrame();
+
+    void beginRenderPass(vk::RenderPass renderPass, vk::Framebuffer framebuffer, vk::Extent2D extent,
+                         const vk::ClearValue* clearValues, uint32_t clearValueCount);
+    void endRenderPass();
+    void bindPipeline(vk::Pipeline pipeline, vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics);
+    void bindVertexBuffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset);
+    void bindIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType indexType);
+    void bindDescriptorSet(vk::PipelineLayout layout, uint32_t firstSet, vk::DescriptorSet set,
+                           vk::PipelineBindPoint bindPoint = vk::PipelineBindPoint::eGraphics);
+    void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    void updateUniform(vk::Buffer buffer, vk::DeviceSize offset, const void* data, uint32_t size);
+    void pushConstants(vk::PipelineLayout layout, vk::ShaderStageFlags stages, uint32_t offset, const void* data, uint32_t size);
+    void fillBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize size, uint32_t data);
+    void memoryBarrier(vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess);
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+    // `countBuffer` may be null, in which case `maxDrawCount` draws are issued
+    void drawIndexedIndirect(vk::Buffer buffer, vk::DeviceSize offset, vk::Buffer countBuffer, vk::DeviceSize countOffset,
+                             uint32_t maxDrawCount, uint32_t stride);
+
+private:
+    std::ofstream file;
+    const CaptureResources& resources;
+    std::vector<uint8_t> frameData;
+    uint32_t frameLimit;
+    uint32_t framesWritten = 0;
+    bool active = true;
+    bool inFrame = false;
+
+    template <typename T>
+    void put(const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        frameData.insert(frameData.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    uint32_t indexOf(const std::vector<T>& table, T handle) const;
+};
+
+struct ReplayFrameStats {
+    double cpuSubmitMs = 0.0;
+    double gpuMs = 0.0;
+};
+
+// Loads a capture and re-issues it as fast as possible, one frame per submit.
+class FrameReplayer {
+public:
+    explicit FrameReplayer(const std::string& path);
+
+    size_t getFrameCount() const { return frames.size(); }
+    // As passed to FrameCapture when the file was recorded
+    uint32_t getConfigFlags() const { return configFlags; }
+
+    // Replays every captured frame `loops` times. `timestampPeriod` is taken from the device
+    // limits and `timestampValidBits` from the queue family; pass 0 bits to skip GPU timing.
+    std::vector<ReplayFrameStats> run(const vk::raii::Device& device,
+                                      const vk::raii::CommandPool& commandPool,
+                                      const vk::raii::Queue& queue,
+                                      const CaptureResources& resources,
+                                      float timestampPeriod,
+                                      uint32_t timestampValidBits,
+                                      uint32_t loops = 1) const;
+
+    // Writes one CSV row per replayed frame followed by a min/avg/p95/max summary.
+    static void report(const std::vector<ReplayFrameStats>& stats, std::ostream& csv, std::ostream& summary);
+
+private:
+    std::vector<std::vector<uint8_t>> frames;
+    uint32_t configFlags = 0;
+
+    void record(const vk::raii::CommandBuffer& commandBuffer, const std::vector<uint8_t>& frame,
+                const CaptureResources& resources) const;
+};
@@ -0,0 +1,123 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    constexpr uint32_t kUnassigned = 0xFFFFFFFF;
+
+    MeshletBounds computeBounds(const MeshletMesh& mesh, const Meshlet& meshlet, const std::vector<glm::vec3>& positions) {
+        MeshletBounds bounds{};
+
+        // Sphere around the AABB centre; close enough to minimal for 64 vertices
+        glm::vec3 minP(std::numeric_limits<float>::max()), maxP(-std::numeric_limits<float>::max());
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+            const glm::vec3& p = positions[mesh.vertices[meshlet.vertexOffset + i]];
+            minP = glm::min(minP, p);
+            maxP = glm::max(maxP, p);
+        }
+        bounds.center = (minP + maxP) * 0.5f;
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+            bounds.radius = std::max(bounds.radius, glm::length(positions[mesh.vertices[meshlet.vertexOffset + i]] - bounds.center));
+        }
+
+        // Normal cone from the triangle normals
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec3> corners;
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+            const uint8_t* tri = &mesh.triangles[(meshlet.triangleOffset + t) * 3];
+            glm::vec3 a = positions[mesh.vertices[meshlet.vertexOffset + tri[0]]];
+            glm::vec3 b = positions[mesh.vertices[meshlet.vertexOffset + tri[1]]];
+            glm::vec3 c = positions[mesh.vertices[meshlet.vertexOffset + tri[2]]];
+
+            glm::vec3 n = glm::cross(b - a, c - a);
+            float area = glm::length(n);
+            if (area <= 0.0f) continue;
+
+            normals.push_back(n / area);
+            corners.push_back(a);
+            axis += n / area;
+        }
+
+        bounds.coneApex = bounds.center;
+        bounds.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        bounds.coneCutoff = 1.0f;
+
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength <= 0.0f) return bounds;
+        axis /= axisLength;
+
+        float minDot = 1.0f;
+        for (const glm::vec3& n : normals) minDot = std::min(minDot, glm::dot(n, axis));
+        // Normals spread over a hemisphere or more: no viewpoint sees only back faces
+        if (minDot <= 0.0f) return bounds;
+
+        // Move the apex back along the axis until every triangle plane lies in front of it
+        float maxT = 0.0f;
+        for (size_t i = 0; i < normals.size(); i++) {
+            float t = glm::dot(bounds.center - corners[i], normals[i]) / glm::dot(axis, normals[i]);
+            maxT = std::max(maxT, t);
+        }
+
+        bounds.coneApex = bounds.center - axis * maxT;
+        bounds.coneAxis = axis;
+        bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        return bounds;
+    }
+}
+
+MeshletMesh buildMeshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices) {
+    if (indices.size() % 3 != 0) throw std::runtime_error("meshlet builder expects a triangle list!");
+
+    MeshletMesh mesh;
+    std::vector<uint32_t> localIndex(positions.size(), kUnassigned);
+    Meshlet current{0, 0, 0, 0};
+
+    auto flush = [&]() {
+        if (current.triangleCount == 0) return;
+        for (uint32_t i = 0; i < current.vertexCount; i++) localIndex[mesh.vertices[current.vertexOffset + i]] = kUnassigned;
+        mesh.meshlets.push_back(current);
+        current = {static_cast<uint32_t>(mesh.vertices.size()), static_cast<uint32_t>(mesh.triangles.size() / 3), 0, 0};
+    };
+
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        uint32_t tri[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        for (uint32_t v : tri) {
+            if (v >= positions.size()) throw std::runtime_error("meshlet builder: index out of range!");
+        }
+
+        uint32_t newVertices = 0;
+        for (int k = 0; k < 3; k++) {
+            bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (localIndex[tri[k]] == kUnassigned && !repeated) newVertices++;
+        }
+
+        if (current.vertexCount + newVertices > kMeshletMaxVertices || current.triangleCount + 1 > kMeshletMaxTriangles) {
+            flush();
+        }
+
+        for (uint32_t v : tri) {
+            if (localIndex[v] == kUnassigned) {
+                localIndex[v] = current.vertexCount++;
+                mesh.vertices.push_back(v);
+            }
+            mesh.triangles.push_back(static_cast<uint8_t>(localIndex[v]));
+        }
+        current.triangleCount++;
+    }
+    flush();
+
+    mesh.bounds.reserve(mesh.meshlets.size());
+    mesh.flattenedIndices.reserve(mesh.triangles.size());
+    for (const Meshlet& meshlet : mesh.meshlets) {
+        mesh.bounds.push_back(computeBounds(mesh, meshlet, positions));
+        for (uint32_t t = 0; t < meshlet.triangleCount * 3; t++) {
+            mesh.flattenedIndices.push_back(mesh.vertices[meshlet.vertexOffset + mesh.triangles[meshlet.triangleOffset * 3 + t]]);
+        }
+    }
+
+    return mesh;
+}
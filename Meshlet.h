@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Cluster limits; 124 keeps a meshlet's local triangle list at 372 bytes, which
+// matches the usual mesh shader output limits should that path be added later.
+constexpr uint32_t kMeshletMaxVertices = 64;
+constexpr uint32_t kMeshletMaxTriangles = 124;
+
+struct Meshlet {
+    uint32_t vertexOffset;    // into MeshletMesh::vertices
+    uint32_t triangleOffset;  // into MeshletMesh::triangles, in triangles
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+struct MeshletBounds {
+    glm::vec3 center;
+    float radius;
+    // Backface cone: the whole cluster faces away from any viewer for which
+    // dot(normalize(apex - viewer), axis) >= cutoff. cutoff == 1 disables the test.
+    glm::vec3 coneApex;
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+struct MeshletMesh {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;   // meshlet-local vertex -> mesh vertex
+    std::vector<uint8_t> triangles;   // three meshlet-local indices per triangle
+
+    // Meshlet triangles re-expanded to mesh vertex indices, so every meshlet is one
+    // contiguous index range: meshlet i starts at 3 * meshlets[i].triangleOffset.
+    std::vector<uint32_t> flattenedIndices;
+};
+
+// Greedily splits an indexed triangle list into clusters, in index order, and computes
+// a bounding sphere and normal cone for each.
+MeshletMesh buildMeshlets(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
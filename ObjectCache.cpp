@@ -0,0 +1,178 @@
+#include "ObjectCache.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace {
+
+// Appends the bytes of a scalar, enum, flag mask or handle, so keys compare by content
+template <typename T>
+void appendKey(std::string& key, const T& value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+DescriptorArena::DescriptorArena(const vk::raii::Device& device, uint32_t initialSets)
+    : device(device), nextPoolSets(initialSets) {}
+
+void DescriptorArena::addPool() {
+    // Sized for the mix of sets this renderer uses; a set that doesn't fit moves on to the next pool
+    uint32_t sets = nextPoolSets;
+    std::array<vk::DescriptorPoolSize, 5> poolSizes = {
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, 2 * sets),
+        vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, sets),
+        vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 4 * sets),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, 4 * sets),
+        vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, sets)
+    };
+    pools.emplace_back(device, vk::DescriptorPoolCreateInfo({}, sets, static_cast<uint32_t>(poolSizes.size()), poolSizes.data()));
+    nextPoolSets = std::min(nextPoolSets * 2, kMaxSetsPerPool);
+}
+
+vk::DescriptorSet DescriptorArena::allocate(vk::DescriptorSetLayout layout) {
+    for (;;) {
+        bool freshPool = currentPool == pools.size();
+        if (freshPool) addPool();
+
+        // A full pool is how the arena learns to move on, so call the C entry point, which
+        // reports that as a result instead of throwing. The pool reclaims the set on reset.
+        vk::DescriptorSetAllocateInfo allocInfo(*pools[currentPool], layout);
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        vk::Result result = static_cast<vk::Result>(device.getDispatcher()->vkAllocateDescriptorSets(
+            static_cast<VkDevice>(*device), &static_cast<const VkDescriptorSetAllocateInfo&>(allocInfo), &set));
+
+        if (result == vk::Result::eSuccess) {
+            allocatedSets++;
+            return vk::DescriptorSet(set);
+        }
+        if (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool) {
+            throw std::runtime_error("failed to allocate descriptor set: " + vk::to_string(result));
+        }
+        if (freshPool) throw std::runtime_error("descriptor set layout does not fit an empty arena pool!");
+        currentPool++;
+    }
+}
+
+void DescriptorArena::reset() {
+    for (auto& pool : pools) pool.reset();
+    currentPool = 0;
+    resets++;
+}
+
+ObjectCache::ObjectCache(const vk::raii::Device& device, uint32_t framesInFlight)
+    : device(device), persistentArena(device, 16) {
+    frameArenas.reserve(framesInFlight);
+    for (uint32_t i = 0; i < framesInFlight; i++) frameArenas.emplace_back(device, 64);
+}
+
+vk::Sampler ObjectCache::getSampler(const vk::SamplerCreateInfo& info) {
+    if (info.pNext) throw std::runtime_error("ObjectCache can't key samplers with a pNext chain!");
+
+    std::string key;
+    appendKey(key, info.flags);
+    appendKey(key, info.magFilter);
+    appendKey(key, info.minFilter);
+    appendKey(key, info.mipmapMode);
+    appendKey(key, info.addressModeU);
+    appendKey(key, info.addressModeV);
+    appendKey(key, info.addressModeW);
+    appendKey(key, info.mipLodBias);
+    appendKey(key, info.anisotropyEnable);
+    appendKey(key, info.maxAnisotropy);
+    appendKey(key, info.compareEnable);
+    appendKey(key, info.compareOp);
+    appendKey(key, info.minLod);
+    appendKey(key, info.maxLod);
+    appendKey(key, info.borderColor);
+    appendKey(key, info.unnormalizedCoordinates);
+
+    stats.samplerRequests++;
+    auto it = samplers.find(key);
+    if (it != samplers.end()) {
+        stats.samplerHits++;
+        return *it->second;
+    }
+    return *samplers.emplace(std::move(key), vk::raii::Sampler(device, info)).first->second;
+}
+
+vk::DescriptorSetLayout ObjectCache::getDescriptorSetLayout(vk::ArrayProxy<const vk::DescriptorSetLayoutBinding> bindings,
+                                                            vk::DescriptorSetLayoutCreateFlags flags) {
+    // Binding order doesn't change the layout, so key (and create) it sorted
+    std::vector<vk::DescriptorSetLayoutBinding> sorted(bindings.begin(), bindings.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+    std::string key;
+    appendKey(key, flags);
+    for (const auto& binding : sorted) {
+        appendKey(key, binding.binding);
+        appendKey(key, binding.descriptorType);
+        appendKey(key, binding.descriptorCount);
+        appendKey(key, binding.stageFlags);
+        bool immutable = binding.pImmutableSamplers != nullptr;
+        appendKey(key, immutable);
+        for (uint32_t i = 0; immutable && i < binding.descriptorCount; i++) appendKey(key, binding.pImmutableSamplers[i]);
+    }
+
+    stats.setLayoutRequests++;
+    auto it = setLayouts.find(key);
+    if (it != setLayouts.end()) {
+        stats.setLayoutHits++;
+        return *it->second;
+    }
+    vk::DescriptorSetLayoutCreateInfo layoutInfo(flags, static_cast<uint32_t>(sorted.size()), sorted.data());
+    return *setLayouts.emplace(std::move(key), vk::raii::DescriptorSetLayout(device, layoutInfo)).first->second;
+}
+
+vk::PipelineLayout ObjectCache::getPipelineLayout(vk::ArrayProxy<const vk::DescriptorSetLayout> setLayoutHandles,
+                                                  vk::ArrayProxy<const vk::PushConstantRange> pushConstantRanges) {
+    // Set layouts are deduplicated above, so their handles stand in for their contents
+    std::string key;
+    appendKey(key, setLayoutHandles.size());
+    for (const auto& setLayout : setLayoutHandles) appendKey(key, setLayout);
+    for (const auto& range : pushConstantRanges) {
+        appendKey(key, range.stageFlags);
+        appendKey(key, range.offset);
+        appendKey(key, range.size);
+    }
+
+    stats.pipelineLayoutRequests++;
+    auto it = pipelineLayouts.find(key);
+    if (it != pipelineLayouts.end()) {
+        stats.pipelineLayoutHits++;
+        return *it->second;
+    }
+    vk::PipelineLayoutCreateInfo layoutInfo({}, setLayoutHandles.size(), setLayoutHandles.data(),
+        pushConstantRanges.size(), pushConstantRanges.data());
+    return *pipelineLayouts.emplace(std::move(key), vk::raii::PipelineLayout(device, layoutInfo)).first->second;
+}
+
+vk::DescriptorSet ObjectCache::allocatePersistentSet(vk::DescriptorSetLayout layout) {
+    return persistentArena.allocate(layout);
+}
+
+void ObjectCache::beginFrame(uint32_t frameIndex) {
+    currentFrame = frameIndex % static_cast<uint32_t>(frameArenas.size());
+    frameArenas[currentFrame].reset();
+}
+
+vk::DescriptorSet ObjectCache::allocateFrameSet(vk::DescriptorSetLayout layout) {
+    return frameArenas[currentFrame].allocate(layout);
+}
+
+ObjectCacheStats ObjectCache::getStats() const {
+    ObjectCacheStats result = stats;
+    result.liveSamplers = static_cast<uint32_t>(samplers.size());
+    result.liveSetLayouts = static_cast<uint32_t>(setLayouts.size());
+    result.livePipelineLayouts = static_cast<uint32_t>(pipelineLayouts.size());
+
+    result.descriptorPools = persistentArena.getPoolCount();
+    result.descriptorSetsAllocated = persistentArena.getAllocatedSets();
+    for (const auto& arena : frameArenas) {
+        result.descriptorPools += arena.getPoolCount();
+        result.descriptorSetsAllocated += arena.getAllocatedSets();
+        result.arenaResets += arena.getResets();
+    }
+    return result;
+}
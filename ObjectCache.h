@@ -0,0 +1,96 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ObjectCacheStats {
+    uint64_t samplerRequests = 0;
+    uint64_t samplerHits = 0;
+    uint64_t setLayoutRequests = 0;
+    uint64_t setLayoutHits = 0;
+    uint64_t pipelineLayoutRequests = 0;
+    uint64_t pipelineLayoutHits = 0;
+    uint32_t liveSamplers = 0;
+    uint32_t liveSetLayouts = 0;
+    uint32_t livePipelineLayouts = 0;
+    uint32_t descriptorPools = 0;       // across the persistent and all frame arenas
+    uint64_t descriptorSetsAllocated = 0;
+    uint64_t arenaResets = 0;
+};
+
+// Descriptor sets carved out of pools that grow on demand and are recycled all at once by
+// reset(). Sets are never freed one by one, so the pools are created without eFreeDescriptorSet.
+class DescriptorArena {
+public:
+    DescriptorArena(const vk::raii::Device& device, uint32_t initialSets);
+
+    vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+    // Every set handed out so far becomes invalid
+    void reset();
+
+    uint32_t getPoolCount() const { return static_cast<uint32_t>(pools.size()); }
+    uint64_t getAllocatedSets() const { return allocatedSets; }
+    uint64_t getResets() const { return resets; }
+
+private:
+    static constexpr uint32_t kMaxSetsPerPool = 4096;
+
+    const vk::raii::Device& device;
+    std::vector<vk::raii::DescriptorPool> pools;
+    size_t currentPool = 0;
+    uint32_t nextPoolSets;
+    uint64_t allocatedSets = 0;
+    uint64_t resets = 0;
+
+    void addPool();
+};
+
+// Deduplicates immutable Vulkan objects by their create info. Identical requests get the same
+// handle back; the cache owns every object and destroys them with itself, so it must outlive
+// anything that uses them. Create infos with a pNext chain are rejected since the chain isn't hashed.
+//
+// Descriptor sets come from a persistent arena that is never reset, or from one arena per
+// frame in flight, which beginFrame() resets once that frame's fence has signalled.
+class ObjectCache {
+public:
+    ObjectCache(const vk::raii::Device& device, uint32_t framesInFlight);
+
+    vk::Sampler getSampler(const vk::SamplerCreateInfo& info);
+    vk::DescriptorSetLayout getDescriptorSetLayout(vk::ArrayProxy<const vk::DescriptorSetLayoutBinding> bindings,
+                                                   vk::DescriptorSetLayoutCreateFlags flags = {});
+    vk::PipelineLayout getPipelineLayout(vk::ArrayProxy<const vk::DescriptorSetLayout> setLayouts,
+                                         vk::ArrayProxy<const vk::PushConstantRange> pushConstantRanges = {});
+
+    // Lives as long as the cache
+    vk::DescriptorSet allocatePersistentSet(vk::DescriptorSetLayout layout);
+    // Recycles the frame slot's arena; its previous submission must have completed
+    void beginFrame(uint32_t frameIndex);
+    // Valid until the current frame slot comes round again
+    vk::DescriptorSet allocateFrameSet(vk::DescriptorSetLayout layout);
+
+    ObjectCacheStats getStats() const;
+
+private:
+    const vk::raii::Device& device;
+
+    std::unordered_map<std::string, vk::raii::Sampler> samplers;
+    std::unordered_map<std::string, vk::raii::DescriptorSetLayout> setLayouts;
+    std::unordered_map<std::string, vk::raii::PipelineLayout> pipelineLayouts;
+
+    DescriptorArena persistentArena;
+    std::vector<DescriptorArena> frameArenas;
+    uint32_t currentFrame = 0;
+
+    ObjectCacheStats stats;
+};
@@ -0,0 +1,355 @@
+#include "OcclusionCuller.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    constexpr uint32_t kCullGroupSize = 64;
+    constexpr uint32_t kPyramidGroupSize = 8;
+
+    uint32_t previousPowerOfTwo(uint32_t v) {
+        uint32_t result = 1;
+        while (result * 2 <= v) result *= 2;
+        return result;
+    }
+}
+
+OcclusionCuller::OcclusionCuller(const vk::raii::Device& device,
+                                 const vk::raii::PhysicalDevice& physicalDevice,
+                                 const vk::raii::CommandPool& commandPool,
+                                 const vk::raii::Queue& queue,
+                                 vk::ImageView depthView,
+                                 vk::Extent2D depthExtent,
+                                 uint32_t instanceCount,
+                                 const glm::vec4& boundingSphere,
+                                 uint32_t indexCount,
+                                 vk::Buffer uniformBuffer,
+                                 vk::DeviceSize uniformSize,
+                                 bool drawIndirectCount,
+                                 bool multiDrawIndirect,
+                                 float timestampPeriod,
+                                 uint32_t timestampValidBits,
+                                 ObjectCache& cache)
+    : instanceCount(instanceCount), indexCount(indexCount), boundingSphere(boundingSphere), depthExtent(depthExtent),
+      drawIndirectCount(drawIndirectCount), multiDrawIndirect(multiDrawIndirect), timestampPeriod(timestampPeriod),
+      timestampMask(timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1) {
+
+    if (instanceCount == 0) throw std::runtime_error("occlusion culling needs at least one instance!");
+    if (depthExtent.width == 0 || depthExtent.height == 0) throw std::runtime_error("occlusion culling needs a depth buffer!");
+
+    // 1. Pyramid: level 0 is the largest power of two that fits inside the depth buffer
+    lastStats.instances = instanceCount;
+    lastStats.pyramidWidth = previousPowerOfTwo(depthExtent.width);
+    lastStats.pyramidHeight = previousPowerOfTwo(depthExtent.height);
+    lastStats.pyramidLevels = 1;
+    while ((std::max(lastStats.pyramidWidth, lastStats.pyramidHeight) >> lastStats.pyramidLevels) > 0) lastStats.pyramidLevels++;
+    createPyramid(device, physicalDevice, commandPool, queue);
+
+    // 2. Per-frame outputs; early and late draws each get `instanceCount` slots
+    createBuffer(device, physicalDevice, vk::DeviceSize(2) * instanceCount * sizeof(vk::DrawIndexedIndirectCommand),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, drawBuffer, drawMemory);
+    createBuffer(device, physicalDevice, 2 * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, countBuffer, countMemory);
+    createBuffer(device, physicalDevice, vk::DeviceSize(instanceCount) * sizeof(uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, visibilityBuffer, visibilityMemory);
+    createBuffer(device, physicalDevice, sizeof(GpuStats),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, statsBuffer, statsMemory);
+    statsMapped = static_cast<GpuStats*>(statsMemory.mapMemory(0, sizeof(GpuStats)));
+    memset(statsMapped, 0, sizeof(GpuStats));
+
+    // 3. GPU timing of the pyramid build
+    if (timestampMask != 0) {
+        queryPool = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, 2));
+    }
+
+    createPipelines(device, cache, depthView, uniformBuffer, uniformSize);
+}
+
+vk::Extent2D OcclusionCuller::levelExtent(uint32_t level) const {
+    return {std::max(lastStats.pyramidWidth >> level, 1u), std::max(lastStats.pyramidHeight >> level, 1u)};
+}
+
+void OcclusionCuller::createPyramid(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                                    const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue) {
+    uint32_t levels = lastStats.pyramidLevels;
+
+    vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, vk::Format::eR32Sfloat,
+        {lastStats.pyramidWidth, lastStats.pyramidHeight, 1}, levels, 1,
+        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferDst);
+    pyramidImage = vk::raii::Image(device, imageInfo);
+
+    vk::MemoryRequirements memReq = pyramidImage.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    pyramidMemory = vk::raii::DeviceMemory(device, allocInfo);
+    pyramidImage.bindMemory(*pyramidMemory, 0);
+
+    vk::ImageViewCreateInfo viewInfo({}, *pyramidImage, vk::ImageViewType::e2D, vk::Format::eR32Sfloat, {},
+        {vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1});
+    pyramidView = vk::raii::ImageView(device, viewInfo);
+    for (uint32_t level = 0; level < levels; level++) {
+        viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, level, 1, 0, 1);
+        pyramidLevelViews.emplace_back(device, viewInfo);
+    }
+
+    // The pyramid lives in eGeneral, read and written by compute only. It starts at the far
+    // plane so the first frame's early phase culls nothing.
+    vk::CommandBufferAllocateInfo cmdInfo(*commandPool, vk::CommandBufferLevel::ePrimary, 1);
+    vk::raii::CommandBuffers cb(device, cmdInfo);
+    vk::raii::CommandBuffer commandBuffer = std::move(cb[0]);
+    commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, levels, 0, 1);
+    vk::ImageMemoryBarrier toGeneral({}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *pyramidImage, range);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, toGeneral);
+    commandBuffer.clearColorImage(*pyramidImage, vk::ImageLayout::eGeneral, vk::ClearColorValue(std::array<float, 4>{1.0f, 0.0f, 0.0f, 0.0f}), range);
+    commandBuffer.end();
+
+    vk::SubmitInfo submitInfo({}, {}, *commandBuffer, {});
+    queue.submit(submitInfo, nullptr);
+    queue.waitIdle();
+}
+
+void OcclusionCuller::createPipelines(const vk::raii::Device& device, ObjectCache& cache, vk::ImageView depthView,
+                                      vk::Buffer uniformBuffer, vk::DeviceSize uniformSize) {
+    uint32_t levels = lastStats.pyramidLevels;
+
+    vk::SamplerCreateInfo samplerInfo({}, vk::Filter::eNearest, vk::Filter::eNearest, vk::SamplerMipmapMode::eNearest,
+        vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge,
+        0.0f, VK_FALSE, 1.0f, VK_FALSE, vk::CompareOp::eAlways, 0.0f, static_cast<float>(levels));
+    pyramidSampler = cache.getSampler(samplerInfo);
+    samplerInfo.maxLod = 0.0f;
+    depthSampler = cache.getSampler(samplerInfo);
+
+    // 1. Cull
+    std::array<vk::DescriptorSetLayoutBinding, 6> cullBindings = {
+        vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(4, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(5, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute)
+    };
+    cullSetLayout = cache.getDescriptorSetLayout(cullBindings);
+    cullSet = cache.allocatePersistentSet(cullSetLayout);
+
+    vk::DescriptorBufferInfo uniformInfo(uniformBuffer, 0, uniformSize);
+    vk::DescriptorImageInfo pyramidInfo(pyramidSampler, *pyramidView, vk::ImageLayout::eGeneral);
+    std::array<vk::DescriptorBufferInfo, 4> storageInfos = {
+        vk::DescriptorBufferInfo(*drawBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*countBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*visibilityBuffer, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(*statsBuffer, 0, VK_WHOLE_SIZE)
+    };
+    std::vector<vk::WriteDescriptorSet> writes = {
+        vk::WriteDescriptorSet(cullSet, 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &uniformInfo),
+        vk::WriteDescriptorSet(cullSet, 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &pyramidInfo)
+    };
+    for (uint32_t i = 0; i < storageInfos.size(); i++) {
+        writes.emplace_back(cullSet, 2 + i, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &storageInfos[i]);
+    }
+    device.updateDescriptorSets(writes, nullptr);
+
+    vk::PushConstantRange cullRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(CullParams));
+    cullPipelineLayout = cache.getPipelineLayout(cullSetLayout, cullRange);
+
+    auto cullCode = readShaderFile("shaders/occlusion_cull.spv");
+    vk::raii::ShaderModule cullModule(device, vk::ShaderModuleCreateInfo({}, cullCode.size(), reinterpret_cast<const uint32_t*>(cullCode.data())));
+
+    // The uniform block's model array is sized by the instance count
+    vk::SpecializationMapEntry specEntry(0, 0, sizeof(uint32_t));
+    vk::SpecializationInfo specInfo(1, &specEntry, sizeof(uint32_t), &instanceCount);
+    vk::PipelineShaderStageCreateInfo cullStage({}, vk::ShaderStageFlagBits::eCompute, *cullModule, "main", &specInfo);
+    cullPipeline = vk::raii::Pipeline(device, nullptr, vk::ComputePipelineCreateInfo({}, cullStage, cullPipelineLayout));
+
+    // 2. Pyramid build, one set per level: scene depth, previous level, target level
+    std::array<vk::DescriptorSetLayoutBinding, 3> pyramidBindings = {
+        vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute),
+        vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute)
+    };
+    pyramidSetLayout = cache.getDescriptorSetLayout(pyramidBindings);
+    for (uint32_t level = 0; level < levels; level++) pyramidSets.push_back(cache.allocatePersistentSet(pyramidSetLayout));
+
+    vk::DescriptorImageInfo depthInfo(depthSampler, depthView, vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+    std::vector<vk::DescriptorImageInfo> sourceInfos, targetInfos;
+    sourceInfos.reserve(levels);
+    targetInfos.reserve(levels);
+    writes.clear();
+    for (uint32_t level = 0; level < levels; level++) {
+        // Level 0 reads the scene depth; its source binding is unused but must be valid
+        sourceInfos.emplace_back(pyramidSampler, *pyramidLevelViews[level == 0 ? 0 : level - 1], vk::ImageLayout::eGeneral);
+        targetInfos.emplace_back(nullptr, *pyramidLevelViews[level], vk::ImageLayout::eGeneral);
+        writes.emplace_back(pyramidSets[level], 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &depthInfo);
+        writes.emplace_back(pyramidSets[level], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &sourceInfos.back());
+        writes.emplace_back(pyramidSets[level], 2, 0, 1, vk::DescriptorType::eStorageImage, &targetInfos.back());
+    }
+    device.updateDescriptorSets(writes, nullptr);
+
+    vk::PushConstantRange pyramidRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(PyramidParams));
+    pyramidPipelineLayout = cache.getPipelineLayout(pyramidSetLayout, pyramidRange);
+
+    auto pyramidCode = readShaderFile("shaders/hiz_downsample.spv");
+    vk::raii::ShaderModule pyramidModule(device, vk::ShaderModuleCreateInfo({}, pyramidCode.size(), reinterpret_cast<const uint32_t*>(pyramidCode.data())));
+    vk::PipelineShaderStageCreateInfo pyramidStage({}, vk::ShaderStageFlagBits::eCompute, *pyramidModule, "main");
+    pyramidPipeline = vk::raii::Pipeline(device, nullptr, vk::ComputePipelineCreateInfo({}, pyramidStage, pyramidPipelineLayout));
+}
+
+void OcclusionCuller::readStats() {
+    lastStats.earlyDrawn = statsMapped->earlyDrawn;
+    lastStats.lateDrawn = statsMapped->lateDrawn;
+    lastStats.frustumCulled = statsMapped->frustumCulled;
+    lastStats.occluded = statsMapped->occluded;
+
+    if (!pyramidTimed) return;
+    auto [result, timestamps] = queryPool.getResults<uint64_t>(0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+    if (result == vk::Result::eSuccess) {
+        // Only the low timestampValidBits are meaningful, and the counter may wrap between the two writes
+        uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask;
+        lastStats.pyramidBuildMs = ticks * timestampPeriod / 1.0e6;
+        lastStats.pyramidBuildTotalMs += lastStats.pyramidBuildMs;
+        lastStats.pyramidBuilds++;
+    }
+    pyramidTimed = false;
+}
+
+void OcclusionCuller::recordCull(const vk::raii::CommandBuffer& commandBuffer, OcclusionPhase phase, const glm::mat4& viewProj,
+                                 FrameCapture* capture) {
+    bool late = phase == OcclusionPhase::Late;
+
+    CullParams params{};
+    extractFrustumPlanes(viewProj, params.frustumPlanes);
+    params.sphere = boundingSphere;
+    params.indexCount = indexCount;
+    params.late = late ? 1 : 0;
+
+    if (!late) {
+        // Without a count buffer the unused slots of both halves must hold zero-sized draws
+        if (!drawIndirectCount) {
+            commandBuffer.fillBuffer(*drawBuffer, 0, VK_WHOLE_SIZE, 0);
+            if (capture) capture->fillBuffer(*drawBuffer, 0, VK_WHOLE_SIZE, 0);
+        }
+        commandBuffer.fillBuffer(*countBuffer, 0, VK_WHOLE_SIZE, 0);
+        commandBuffer.fillBuffer(*statsBuffer, 0, VK_WHOLE_SIZE, 0);
+        if (capture) {
+            capture->fillBuffer(*countBuffer, 0, VK_WHOLE_SIZE, 0);
+            capture->fillBuffer(*statsBuffer, 0, VK_WHOLE_SIZE, 0);
+        }
+    }
+
+    // Clears, the previous phase's visibility and the pyramid writes all land before the cull reads them
+    vk::PipelineStageFlags srcStage = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader;
+    vk::MemoryBarrier readyBarrier(vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite,
+        vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(srcStage, vk::PipelineStageFlagBits::eComputeShader, {}, readyBarrier, {}, {});
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *cullPipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, cullPipelineLayout, 0, cullSet, nullptr);
+    commandBuffer.pushConstants<CullParams>(cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, params);
+
+    uint32_t groupCount = (instanceCount + kCullGroupSize - 1) / kCullGroupSize;
+    commandBuffer.dispatch(groupCount, 1, 1);
+
+    vk::PipelineStageFlags dstStage = vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eHost;
+    vk::MemoryBarrier cullBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eHostRead);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStage, {}, cullBarrier, {}, {});
+
+    if (capture) {
+        capture->memoryBarrier(srcStage, vk::PipelineStageFlagBits::eComputeShader, readyBarrier.srcAccessMask, readyBarrier.dstAccessMask);
+        capture->bindPipeline(*cullPipeline, vk::PipelineBindPoint::eCompute);
+        capture->bindDescriptorSet(cullPipelineLayout, 0, cullSet, vk::PipelineBindPoint::eCompute);
+        capture->pushConstants(cullPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, &params, sizeof(params));
+        capture->dispatch(groupCount, 1, 1);
+        capture->memoryBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStage, cullBarrier.srcAccessMask, cullBarrier.dstAccessMask);
+    }
+}
+
+void OcclusionCuller::recordPyramidBuild(const vk::raii::CommandBuffer& commandBuffer, FrameCapture* capture) {
+    // Early depth is made visible by the render pass; this orders the build after the early cull's pyramid reads
+    vk::MemoryBarrier startBarrier(vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, startBarrier, {}, {});
+    if (capture) {
+        capture->memoryBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+            startBarrier.srcAccessMask, startBarrier.dstAccessMask);
+    }
+
+    if (*queryPool) {
+        commandBuffer.resetQueryPool(*queryPool, 0, 2);
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 0);
+    }
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pyramidPipeline);
+    if (capture) capture->bindPipeline(*pyramidPipeline, vk::PipelineBindPoint::eCompute);
+
+    vk::MemoryBarrier levelBarrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+    for (uint32_t level = 0; level < lastStats.pyramidLevels; level++) {
+        PyramidParams params{};
+        vk::Extent2D source = level == 0 ? depthExtent : levelExtent(level - 1);
+        vk::Extent2D target = levelExtent(level);
+        params.sourceSize = glm::uvec2(source.width, source.height);
+        params.targetSize = glm::uvec2(target.width, target.height);
+        params.level = level;
+
+        uint32_t groupsX = (target.width + kPyramidGroupSize - 1) / kPyramidGroupSize;
+        uint32_t groupsY = (target.height + kPyramidGroupSize - 1) / kPyramidGroupSize;
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pyramidPipelineLayout, 0, pyramidSets[level], nullptr);
+        commandBuffer.pushConstants<PyramidParams>(pyramidPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, params);
+        commandBuffer.dispatch(groupsX, groupsY, 1);
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, levelBarrier, {}, {});
+
+        if (capture) {
+            capture->bindDescriptorSet(pyramidPipelineLayout, 0, pyramidSets[level], vk::PipelineBindPoint::eCompute);
+            capture->pushConstants(pyramidPipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, &params, sizeof(params));
+            capture->dispatch(groupsX, groupsY, 1);
+            capture->memoryBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+                levelBarrier.srcAccessMask, levelBarrier.dstAccessMask);
+        }
+    }
+
+    if (*queryPool) {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
+        pyramidTimed = true;
+    }
+}
+
+void OcclusionCuller::recordDraw(const vk::raii::CommandBuffer& commandBuffer, OcclusionPhase phase, FrameCapture* capture) const {
+    constexpr uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+    uint32_t half = phase == OcclusionPhase::Late ? 1 : 0;
+    vk::DeviceSize drawOffset = vk::DeviceSize(half) * instanceCount * stride;
+    vk::DeviceSize countOffset = half * sizeof(uint32_t);
+
+    if (drawIndirectCount) {
+        commandBuffer.drawIndexedIndirectCount(*drawBuffer, drawOffset, *countBuffer, countOffset, instanceCount, stride);
+        if (capture) capture->drawIndexedIndirect(*drawBuffer, drawOffset, *countBuffer, countOffset, instanceCount, stride);
+    } else if (multiDrawIndirect) {
+        commandBuffer.drawIndexedIndirect(*drawBuffer, drawOffset, instanceCount, stride);
+        if (capture) capture->drawIndexedIndirect(*drawBuffer, drawOffset, nullptr, 0, instanceCount, stride);
+    } else {
+        for (uint32_t i = 0; i < instanceCount; i++) {
+            vk::DeviceSize offset = drawOffset + vk::DeviceSize(i) * stride;
+            commandBuffer.drawIndexedIndirect(*drawBuffer, offset, 1, stride);
+            if (capture) capture->drawIndexedIndirect(*drawBuffer, offset, nullptr, 0, 1, stride);
+        }
+    }
+}
+
+void OcclusionCuller::registerCaptureResources(CaptureResources& resources) const {
+    resources.pipelines.push_back(*cullPipeline);
+    resources.pipelines.push_back(*pyramidPipeline);
+    resources.pipelineLayouts.push_back(cullPipelineLayout);
+    resources.pipelineLayouts.push_back(pyramidPipelineLayout);
+    resources.descriptorSets.push_back(cullSet);
+    for (vk::DescriptorSet set : pyramidSets) resources.descriptorSets.push_back(set);
+    for (vk::Buffer buffer : {*drawBuffer, *countBuffer, *visibilityBuffer, *statsBuffer}) {
+        resources.buffers.push_back(buffer);
+        resources.mappedBuffers.push_back(nullptr);
+    }
+}
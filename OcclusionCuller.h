@@ -0,0 +1,150 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "FrameCapture.h"
+#include "ObjectCache.h"
+
+struct OcclusionCullStats {
+    uint32_t instances = 0;
+    uint32_t earlyDrawn = 0;       // passed against the previous frame's pyramid
+    uint32_t lateDrawn = 0;        // rejected early, visible against this frame's pyramid
+    uint32_t frustumCulled = 0;
+    uint32_t occluded = 0;
+    uint32_t pyramidWidth = 0;
+    uint32_t pyramidHeight = 0;
+    uint32_t pyramidLevels = 0;
+    double pyramidBuildMs = 0.0;   // GPU time of the last build; 0 without timestamp support
+    double pyramidBuildTotalMs = 0.0;
+    uint64_t pyramidBuilds = 0;
+};
+
+enum class OcclusionPhase { Early, Late };
+
+// Two-phase Hi-Z occlusion culling for one mesh drawn `instanceCount` times.
+//
+// The early phase tests each instance's bounding sphere against the frustum and against a
+// depth pyramid built from the previous frame, and draws the survivors. The pyramid is
+// then rebuilt from the early pass's depth by a compute downsample (max of each 2x2
+// footprint). The late phase re-tests only the instances the early phase rejected, and
+// draws the ones that turn out to be visible. An instance that moves into view is
+// therefore drawn in the same frame.
+//
+// The scene pass must be split around this (ScenePass::Early / ScenePass::Late), and the
+// depth attachment needs eSampled usage and must be multisampled.
+class OcclusionCuller {
+public:
+    OcclusionCuller(const vk::raii::Device& device,
+                    const vk::raii::PhysicalDevice& physicalDevice,
+                    const vk::raii::CommandPool& commandPool,
+                    const vk::raii::Queue& queue,
+                    vk::ImageView depthView,
+                    vk::Extent2D depthExtent,
+                    uint32_t instanceCount,
+                    const glm::vec4& boundingSphere,
+                    uint32_t indexCount,
+                    vk::Buffer uniformBuffer,
+                    vk::DeviceSize uniformSize,
+                    bool drawIndirectCount,
+                    bool multiDrawIndirect,
+                    float timestampPeriod,
+                    uint32_t timestampValidBits,
+                    ObjectCache& cache);
+
+    // Call once the previous frame's fence has signalled, before recording the next cull
+    void readStats();
+    const OcclusionCullStats& getStats() const { return lastStats; }
+
+    // Records one culling phase. Must be outside a render pass, after the uniforms are written.
+    void recordCull(const vk::raii::CommandBuffer& commandBuffer, OcclusionPhase phase, const glm::mat4& viewProj,
+                    FrameCapture* capture);
+    // Rebuilds the pyramid from the depth attachment. Record between the early and late
+    // passes, while depth is in eDepthStencilReadOnlyOptimal.
+    void recordPyramidBuild(const vk::raii::CommandBuffer& commandBuffer, FrameCapture* capture);
+    // Records the phase's draws. Expects the graphics pipeline, vertex and index buffers and
+    // descriptor sets to be bound already.
+    void recordDraw(const vk::raii::CommandBuffer& commandBuffer, OcclusionPhase phase, FrameCapture* capture) const;
+
+    void registerCaptureResources(CaptureResources& resources) const;
+
+private:
+    // Mirror of `CullParams` in shaders/occlusion_cull.comp
+    struct CullParams {
+        glm::vec4 frustumPlanes[6];
+        glm::vec4 sphere;
+        uint32_t indexCount;
+        uint32_t late;
+    };
+
+    // Mirror of `PyramidParams` in shaders/hiz_downsample.comp
+    struct PyramidParams {
+        glm::uvec2 sourceSize;
+        glm::uvec2 targetSize;
+        uint32_t level;
+    };
+
+    // Mirror of `Stats` in shaders/occlusion_cull.comp
+    struct GpuStats {
+        uint32_t earlyDrawn;
+        uint32_t lateDrawn;
+        uint32_t frustumCulled;
+        uint32_t occluded;
+    };
+
+    uint32_t instanceCount;
+    uint32_t indexCount;
+    glm::vec4 boundingSphere;
+    vk::Extent2D depthExtent;
+    bool drawIndirectCount;
+    bool multiDrawIndirect;
+    float timestampPeriod;
+    uint64_t timestampMask;           // low timestampValidBits set; 0 when the queue can't time
+
+    vk::raii::Image pyramidImage = nullptr;
+    vk::raii::DeviceMemory pyramidMemory = nullptr;
+    vk::raii::ImageView pyramidView = nullptr;            // all levels, for the cull
+    std::vector<vk::raii::ImageView> pyramidLevelViews;   // one per level, for the build
+    vk::Sampler depthSampler;                             // samplers, layouts and sets are owned by the ObjectCache
+    vk::Sampler pyramidSampler;
+
+    vk::raii::Buffer drawBuffer = nullptr;
+    vk::raii::DeviceMemory drawMemory = nullptr;
+    vk::raii::Buffer countBuffer = nullptr;
+    vk::raii::DeviceMemory countMemory = nullptr;
+    vk::raii::Buffer visibilityBuffer = nullptr;
+    vk::raii::DeviceMemory visibilityMemory = nullptr;
+    vk::raii::Buffer statsBuffer = nullptr;
+    vk::raii::DeviceMemory statsMemory = nullptr;
+    GpuStats* statsMapped = nullptr;
+    OcclusionCullStats lastStats;
+
+    vk::raii::QueryPool queryPool = nullptr;
+    bool pyramidTimed = false;
+
+    vk::DescriptorSetLayout cullSetLayout;
+    vk::DescriptorSet cullSet;
+    vk::PipelineLayout cullPipelineLayout;
+    vk::raii::Pipeline cullPipeline = nullptr;
+    vk::DescriptorSetLayout pyramidSetLayout;
+    std::vector<vk::DescriptorSet> pyramidSets;           // one per level
+    vk::PipelineLayout pyramidPipelineLayout;
+    vk::raii::Pipeline pyramidPipeline = nullptr;
+
+    vk::Extent2D levelExtent(uint32_t level) const;
+
+    void createPyramid(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                       const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue);
+    void createPipelines(const vk::raii::Device& device, ObjectCache& cache, vk::ImageView depthView,
+                         vk::Buffer uniformBuffer, vk::DeviceSize uniformSize);
+};
@@ -0,0 +1,137 @@
+#include "PageFile.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr char kPageFileMagic[4] = {'V', 'T', 'P', 'F'};
+    constexpr uint32_t kPageFileVersion = 1;
+
+    bool isPowerOfTwo(uint32_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+    struct MipImage {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    // 2x2 box filter, done directly on the sRGB bytes like the rest of the texture path
+    MipImage downsample(const MipImage& src) {
+        MipImage dst{std::max(1u, src.width / 2), std::max(1u, src.height / 2), {}};
+        dst.pixels.resize(size_t(dst.width) * dst.height * 4);
+
+        for (uint32_t y = 0; y < dst.height; y++) {
+            for (uint32_t x = 0; x < dst.width; x++) {
+                uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+                uint32_t y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+                for (uint32_t c = 0; c < 4; c++) {
+                    uint32_t sum = src.pixels[(size_t(y0) * src.width + x0) * 4 + c]
+                                 + src.pixels[(size_t(y0) * src.width + x1) * 4 + c]
+                                 + src.pixels[(size_t(y1) * src.width + x0) * 4 + c]
+                                 + src.pixels[(size_t(y1) * src.width + x1) * 4 + c];
+                    dst.pixels[(size_t(y) * dst.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+}
+
+void PageFile::bake(const std::string& imagePath, const std::string& pageFilePath, uint32_t pageSize, uint32_t border) {
+    int texWidth, texHeight, texChannels;
+    stbi_uc* pixels = stbi_load(imagePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (!pixels) {
+        throw std::runtime_error("failed to load texture image: " + imagePath);
+    }
+
+    uint32_t width = static_cast<uint32_t>(texWidth), height = static_cast<uint32_t>(texHeight);
+    if (!isPowerOfTwo(width) || !isPowerOfTwo(height) || std::max(width, height) < pageSize) {
+        stbi_image_free(pixels);
+        throw std::runtime_error("virtual textures must be power-of-two sized and at least one page: " + imagePath);
+    }
+
+    // Mip chain down to the level that fits into a single page
+    std::vector<MipImage> mips;
+    mips.push_back({width, height, std::vector<uint8_t>(pixels, pixels + size_t(width) * height * 4)});
+    stbi_image_free(pixels);
+    while (std::max(mips.back().width, mips.back().height) > pageSize) {
+        mips.push_back(downsample(mips.back()));
+    }
+
+    PageFileHeader header{};
+    memcpy(header.magic, kPageFileMagic, sizeof(kPageFileMagic));
+    header.version = kPageFileVersion;
+    header.width = width;
+    header.height = height;
+    header.pageSize = pageSize;
+    header.border = border;
+    header.mipCount = static_cast<uint32_t>(mips.size());
+
+    std::ofstream out(pageFilePath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("failed to open page file: " + pageFilePath);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint32_t tileSize = pageSize + 2 * border;
+    std::vector<uint8_t> tile(size_t(tileSize) * tileSize * 4);
+
+    for (const MipImage& mip : mips) {
+        uint32_t pagesX = std::max(1u, mip.width / pageSize);
+        uint32_t pagesY = std::max(1u, mip.height / pageSize);
+
+        for (uint32_t py = 0; py < pagesY; py++) {
+            for (uint32_t px = 0; px < pagesX; px++) {
+                // Border texels are clamped to the mip edge; interior borders copy the neighbour page
+                for (uint32_t ty = 0; ty < tileSize; ty++) {
+                    int64_t sy = std::clamp<int64_t>(int64_t(py) * pageSize + ty - border, 0, mip.height - 1);
+                    for (uint32_t tx = 0; tx < tileSize; tx++) {
+                        int64_t sx = std::clamp<int64_t>(int64_t(px) * pageSize + tx - border, 0, mip.width - 1);
+                        memcpy(&tile[(size_t(ty) * tileSize + tx) * 4], &mip.pixels[(size_t(sy) * mip.width + sx) * 4], 4);
+                    }
+                }
+                out.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+            }
+        }
+    }
+
+    if (!out) throw std::runtime_error("failed to write page file: " + pageFilePath);
+}
+
+PageFile::PageFile(const std::string& path) : file(path, std::ios::binary) {
+    if (!file.is_open()) throw std::runtime_error("failed to open page file: " + path);
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || memcmp(header.magic, kPageFileMagic, sizeof(kPageFileMagic)) != 0 || header.version != kPageFileVersion) {
+        throw std::runtime_error("not a supported page file: " + path);
+    }
+    if (header.mipCount == 0 || header.mipCount > 32) {
+        throw std::runtime_error("corrupt page file: " + path);
+    }
+
+    uint64_t pageIndex = 0;
+    for (uint32_t mip = 0; mip < header.mipCount; mip++) {
+        mipPageOffsets[mip] = pageIndex;
+        pageIndex += uint64_t(getPagesX(mip)) * getPagesY(mip);
+    }
+}
+
+uint32_t PageFile::getPagesX(uint32_t mip) const {
+    return std::max(1u, (header.width >> mip) / header.pageSize);
+}
+
+uint32_t PageFile::getPagesY(uint32_t mip) const {
+    return std::max(1u, (header.height >> mip) / header.pageSize);
+}
+
+void PageFile::readPage(uint32_t mip, uint32_t x, uint32_t y, uint8_t* dst) {
+    if (mip >= header.mipCount || x >= getPagesX(mip) || y >= getPagesY(mip)) {
+        throw std::runtime_error("page request out of range!");
+    }
+
+    uint64_t pageIndex = mipPageOffsets[mip] + uint64_t(y) * getPagesX(mip) + x;
+    file.seekg(sizeof(PageFileHeader) + pageIndex * getTileBytes());
+    file.read(reinterpret_cast<char*>(dst), getTileBytes());
+    if (!file) throw std::runtime_error("failed to read page from page file!");
+}
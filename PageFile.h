@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// On-disk layout of a virtual texture: a header followed by every page of every mip,
+// mip 0 first and row-major inside each mip. Each page is stored as a square RGBA8
+// tile of (pageSize + 2 * border) texels so bilinear filtering never reads a neighbour.
+struct PageFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pageSize;
+    uint32_t border;
+    uint32_t mipCount;
+};
+
+class PageFile {
+public:
+    static constexpr uint32_t kDefaultPageSize = 128;
+    static constexpr uint32_t kDefaultBorder = 4;
+
+    // Offline step: tiles `imagePath` and its box-filtered mip chain into a page file.
+    // Image dimensions must be powers of two and at least one page wide.
+    static void bake(const std::string& imagePath, const std::string& pageFilePath,
+                     uint32_t pageSize = kDefaultPageSize, uint32_t border = kDefaultBorder);
+
+    explicit PageFile(const std::string& path);
+
+    const PageFileHeader& getHeader() const { return header; }
+    uint32_t getTileSize() const { return header.pageSize + 2 * header.border; }
+    size_t getTileBytes() const { return size_t(getTileSize()) * getTileSize() * 4; }
+
+    uint32_t getPagesX(uint32_t mip) const;
+    uint32_t getPagesY(uint32_t mip) const;
+
+    // Reads one tile into `dst` (getTileBytes() bytes). Not thread-safe; each thread
+    // that streams pages should open its own PageFile.
+    void readPage(uint32_t mip, uint32_t x, uint32_t y, uint8_t* dst);
+
+private:
+    std::ifstream file;
+    PageFileHeader header{};
+    uint64_t mipPageOffsets[32] = {};
+};
@@ -0,0 +1,214 @@
+#include "Scene.h"
+#include "Model.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+void updateInstanceTransforms(glm::mat4* models, uint32_t first, uint32_t count, float time) {
+    glm::mat4 spin = glm::rotate(glm::mat4(1.0f), time * glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    for (uint32_t i = 0; i < count; i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, (first + i) * -2.5f, 0.0f));
+        models[i] = model * spin;
+    }
+}
+
+void updateSceneCamera(SceneUniforms& uniforms, const glm::vec3& cameraPosition, vk::Extent2D extent) {
+    uniforms.view = glm::lookAt(cameraPosition, glm::vec3(0.0f, -10.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    uniforms.proj = glm::perspective(glm::radians(45.0f), extent.width / (float) extent.height, 0.1f, 100.0f);
+    uniforms.proj[1][1] *= -1;
+}
+
+void extractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row2;
+    planes[5] = row3 - row2;
+    for (int i = 0; i < 6; i++) planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+vk::raii::RenderPass createSceneRenderPass(const vk::raii::Device& device, vk::Format colorFormat, vk::Format depthFormat,
+                                           vk::SampleCountFlagBits samples, vk::ImageLayout resolveFinalLayout, ScenePass pass) {
+    bool early = pass == ScenePass::Early;
+    bool late = pass == ScenePass::Late;
+
+    // 1. Multisampled Color; only the early pass needs it after the subpass, everything else resolves
+    vk::AttachmentDescription colorAttachment({}, colorFormat, samples,
+        late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+        early ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+        vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+        late ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal);
+    // 2. Multisampled Depth; the early pass hands it to the Hi-Z build
+    vk::AttachmentDescription depthAttachment({}, depthFormat, samples,
+        late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+        early ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare,
+        vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+        late ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eUndefined,
+        early ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    // 3. Resolve Attachment; the early pass still references it (render pass compatibility
+    // requires matching references) but discards the result, the late pass resolves again
+    vk::AttachmentDescription colorAttachmentResolve({}, colorFormat, vk::SampleCountFlagBits::e1,
+        vk::AttachmentLoadOp::eDontCare, early ? vk::AttachmentStoreOp::eDontCare : vk::AttachmentStoreOp::eStore,
+        vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+        vk::ImageLayout::eUndefined, early ? vk::ImageLayout::eColorAttachmentOptimal : resolveFinalLayout);
+
+    vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+    vk::AttachmentReference depthRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    vk::AttachmentReference resolveRef(2, vk::ImageLayout::eColorAttachmentOptimal);
+
+    vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorRef, &resolveRef, &depthRef);
+    std::array<vk::AttachmentDescription, 3> attachments = {colorAttachment, depthAttachment, colorAttachmentResolve};
+
+    // The late pass also waits for the compute reads of the early depth before writing it again
+    std::array<vk::SubpassDependency, 2> dependencies = {
+        vk::SubpassDependency(VK_SUBPASS_EXTERNAL, 0,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                (late ? vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eLateFragmentTests : vk::PipelineStageFlags{}),
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+            late ? vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite : vk::AccessFlags{},
+            vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+                (late ? vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentRead : vk::AccessFlags{})),
+        // Early depth writes become visible to the pyramid build
+        vk::SubpassDependency(0, VK_SUBPASS_EXTERNAL,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests,
+            vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+            vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+            vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentRead)
+    };
+    uint32_t dependencyCount = early ? 2 : 1;
+
+    vk::RenderPassCreateInfo renderPassInfo({}, static_cast<uint32_t>(attachments.size()), attachments.data(), 1, &subpass, dependencyCount, dependencies.data());
+    return vk::raii::RenderPass(device, renderPassInfo);
+}
+
+vk::raii::Pipeline createScenePipeline(const vk::raii::Device& device, const std::vector<char>& vertCode,
+                                       const std::vector<char>& fragCode, vk::PipelineLayout layout,
+                                       vk::RenderPass renderPass, vk::Extent2D extent, vk::SampleCountFlagBits samples,
+                                       vk::CullModeFlags cullMode, const vk::PipelineRenderingCreateInfo* renderingInfo) {
+    vk::raii::ShaderModule vertModule(device, vk::ShaderModuleCreateInfo({}, vertCode.size(), reinterpret_cast<const uint32_t*>(vertCode.data())));
+    vk::raii::ShaderModule fragModule(device, vk::ShaderModuleCreateInfo({}, fragCode.size(), reinterpret_cast<const uint32_t*>(fragCode.data())));
+
+    vk::PipelineShaderStageCreateInfo shaderStages[] = {
+        {{}, vk::ShaderStageFlagBits::eVertex, *vertModule, "main"},
+        {{}, vk::ShaderStageFlagBits::eFragment, *fragModule, "main"}
+    };
+
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+
+    vk::PipelineDepthStencilStateCreateInfo depthStencil({}, VK_TRUE, VK_TRUE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, vk::PrimitiveTopology::eTriangleList, VK_FALSE);
+    vk::Viewport viewport(0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f);
+    vk::Rect2D scissor({0, 0}, extent);
+    vk::PipelineViewportStateCreateInfo viewportState({}, 1, &viewport, 1, &scissor);
+    vk::PipelineRasterizationStateCreateInfo rasterizer({}, VK_FALSE, VK_FALSE, vk::PolygonMode::eFill, cullMode, vk::FrontFace::eCounterClockwise, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f);
+    vk::PipelineMultisampleStateCreateInfo multisampling({}, samples, VK_FALSE);
+    vk::PipelineColorBlendAttachmentState colorBlendAttachment(VK_FALSE, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
+    vk::PipelineColorBlendStateCreateInfo colorBlending({}, VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment);
+
+    vk::GraphicsPipelineCreateInfo pipelineInfo({}, 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, nullptr, layout, renderPass, 0);
+    pipelineInfo.pNext = renderingInfo;
+    return vk::raii::Pipeline(device, nullptr, pipelineInfo);
+}
+
+std::vector<char> readShaderFile(const std::string& filename) {
+    std::ifstream file;
+#ifdef TRIANGLE_SHADER_BINARY_DIR
+    // Shaders compiled by the build live in the build tree, not next to their sources
+    file.open(std::string(TRIANGLE_SHADER_BINARY_DIR) + "/" + filename, std::ios::ate | std::ios::binary);
+#endif
+    if (!file.is_open()) file.open(filename, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) throw std::runtime_error("failed to open file: " + filename);
+    size_t fileSize = (size_t) file.tellg();
+    std::vector<char> buffer(fileSize);
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+    return buffer;
+}
+
+void createBuffer(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                  vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties,
+                  vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory) {
+    vk::BufferCreateInfo bufferInfo({}, size, usage, vk::SharingMode::eExclusive);
+    buffer = vk::raii::Buffer(device, bufferInfo);
+
+    vk::MemoryRequirements memRequirements = buffer.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo(memRequirements.size, findMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties));
+    memory = vk::raii::DeviceMemory(device, allocInfo);
+    buffer.bindMemory(*memory, 0);
+}
+
+void uploadBuffer(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                  const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue,
+                  const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage,
+                  vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory) {
+    vk::raii::Buffer stagingBuffer = nullptr;
+    vk::raii::DeviceMemory stagingMemory = nullptr;
+    createBuffer(device, physicalDevice, size, vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingMemory);
+
+    void* mapped = stagingMemory.mapMemory(0, size);
+    memcpy(mapped, data, static_cast<size_t>(size));
+    stagingMemory.unmapMemory();
+
+    createBuffer(device, physicalDevice, size, usage | vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, memory);
+
+    vk::CommandBufferAllocateInfo allocInfo(*commandPool, vk::CommandBufferLevel::ePrimary, 1);
+    vk::raii::CommandBuffers cb(device, allocInfo);
+    vk::raii::CommandBuffer commandBuffer = std::move(cb[0]);
+
+    commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    commandBuffer.copyBuffer(*stagingBuffer, *buffer, vk::BufferCopy(0, 0, size));
+    commandBuffer.end();
+
+    vk::SubmitInfo submitInfo({}, {}, *commandBuffer, {});
+    queue.submit(submitInfo, nullptr);
+    queue.waitIdle();
+}
+
+uint32_t findMemoryType(const vk::raii::PhysicalDevice& physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
+    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+vk::raii::DeviceMemory allocateAttachmentMemory(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                                                const vk::MemoryRequirements& memReq, bool transient, bool& lazy) {
+    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
+    vk::MemoryPropertyFlags lazyFlags = vk::MemoryPropertyFlagBits::eDeviceLocal | vk::MemoryPropertyFlagBits::eLazilyAllocated;
+
+    uint32_t typeIndex = 0;
+    lazy = false;
+    for (uint32_t i = 0; transient && i < memProperties.memoryTypeCount; i++) {
+        if ((memReq.memoryTypeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & lazyFlags) == lazyFlags) {
+            typeIndex = i;
+            lazy = true;
+            break;
+        }
+    }
+    if (!lazy) typeIndex = findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+
+    return vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo(memReq.size, typeIndex));
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#ifndef GLM_FORCE_DEPTH_ZERO_TO_ONE
+    #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#endif
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shared scene setup for Triangle and TriangleBench, so both exercise the same
+// render pass, pipeline state and per-instance transforms.
+
+// Length of the `models` array in shaders/vert.spv; larger instance counts are drawn in batches
+constexpr uint32_t kSceneBatchSize = 10;
+
+struct SceneUniforms {
+    alignas(16) glm::mat4 models[kSceneBatchSize];
+    alignas(16) glm::mat4 view;
+    alignas(16) glm::mat4 proj;
+};
+
+// Writes the model matrices for instances [first, first + count) into `models`,
+// stacking instances along -Y and spinning them about Z.
+void updateInstanceTransforms(glm::mat4* models, uint32_t first, uint32_t count, float time);
+
+// Fills view/proj for the fixed scene camera (Vulkan clip space, Y flipped)
+void updateSceneCamera(SceneUniforms& uniforms, const glm::vec3& cameraPosition, vk::Extent2D extent);
+
+// World-space frustum planes (xyz normal pointing inwards, w distance) for 0..1 clip depth
+void extractFrustumPlanes(const glm::mat4& viewProj, glm::vec4 planes[6]);
+
+// Occlusion culling splits the scene pass in two. `Early` clears and keeps the multisampled
+// color and depth, leaving depth readable by compute, and discards its resolve. `Late` loads
+// both, draws the rest and resolves. Both keep the resolve reference so they stay compatible
+// with `Full` and share its framebuffers and pipelines.
+enum class ScenePass { Full, Early, Late };
+
+// Multisampled color + depth, resolved into a single-sample attachment left in `resolveFinalLayout`
+vk::raii::RenderPass createSceneRenderPass(const vk::raii::Device& device, vk::Format colorFormat, vk::Format depthFormat,
+                                           vk::SampleCountFlagBits samples, vk::ImageLayout resolveFinalLayout,
+                                           ScenePass pass = ScenePass::Full);
+
+// The scene's graphics pipeline: Vertex input, depth test, counter-clockwise front faces, fixed viewport.
+// For dynamic rendering pass a null renderPass and the attachment formats in `renderingInfo`.
+vk::raii::Pipeline createScenePipeline(const vk::raii::Device& device, const std::vector<char>& vertCode,
+                                       const std::vector<char>& fragCode, vk::PipelineLayout layout,
+                                       vk::RenderPass renderPass, vk::Extent2D extent, vk::SampleCountFlagBits samples,
+                                       vk::CullModeFlags cullMode = vk::CullModeFlagBits::eNone,
+                                       const vk::PipelineRenderingCreateInfo* renderingInfo = nullptr);
+
+// Looks in the build's shader output directory first, then relative to the working directory
+std::vector<char> readShaderFile(const std::string& filename);
+
+// Memory helpers shared by everything in the renderer that owns GPU resources
+uint32_t findMemoryType(const vk::raii::PhysicalDevice& physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties);
+void createBuffer(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                  vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties,
+                  vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory);
+// Device-local buffer filled through a staging copy; waits for the queue to go idle
+void uploadBuffer(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                  const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue,
+                  const void* data, vk::DeviceSize size, vk::BufferUsageFlags usage,
+                  vk::raii::Buffer& buffer, vk::raii::DeviceMemory& memory);
+// Memory for an MSAA color or depth attachment. A `transient` attachment (one created with
+// eTransientAttachment) gets lazily allocated memory where the device has it, which tile-based
+// GPUs may never commit; `lazy` reports whether it did. Everything else is plain device-local.
+vk::raii::DeviceMemory allocateAttachmentMemory(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice,
+                                                const vk::MemoryRequirements& memReq, bool transient, bool& lazy);
@@ -1,13 +1,15 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "Texture.h"
+#include "Scene.h"
 #include <stdexcept>
 
 Texture::Texture(const vk::raii::Device& device, 
                  const vk::raii::PhysicalDevice& physicalDevice, 
                  const vk::raii::CommandPool& commandPool, 
                  const vk::raii::Queue& queue, 
-                 const std::string& path) {
+                 const std::string& path,
+                 ObjectCache* cache) {
 
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load(path.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
@@ -58,14 +60,19 @@ Texture::Texture(const vk::raii::Device& device,
     vk::ImageViewCreateInfo viewInfo({}, *image, vk::ImageViewType::e2D, vk::Format::eR8G8B8A8Srgb, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
     imageView = vk::raii::ImageView(device, viewInfo);
 
-    // Create Sampler
+    // Create Sampler; textures share one through the cache when there is one
     vk::SamplerCreateInfo samplerInfo({}, vk::Filter::eLinear, vk::Filter::eLinear, 
         vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eRepeat, 
         vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, 
         0.0f, VK_FALSE, 1.0f, VK_FALSE, vk::CompareOp::eAlways, 0.0f, 0.0f, 
         vk::BorderColor::eIntOpaqueBlack, VK_FALSE);
 
-    sampler = vk::raii::Sampler(device, samplerInfo);
+    if (cache) {
+        sampler = cache->getSampler(samplerInfo);
+    } else {
+        ownedSampler = vk::raii::Sampler(device, samplerInfo);
+        sampler = *ownedSampler;
+    }
 }
 
 void Texture::transitionImageLayout(const vk::raii::Device& device, const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue, vk::ImageLayout oldLayout, vk::ImageLayout newLayout) {
@@ -113,13 +120,3 @@ void Texture::copyBufferToImage(const vk::raii::Device& device, const vk::raii::
     queue.submit(submitInfo, nullptr);
     queue.waitIdle();
 }
-
-uint32_t Texture::findMemoryType(const vk::raii::PhysicalDevice& physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
-    vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-    throw std::runtime_error("failed to find suitable memory type!");
-}
\ No newline at end of file
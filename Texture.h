@@ -11,30 +11,32 @@
 
 #include <string>
 
+#include "ObjectCache.h"
+
 class Texture {
 public:
     Texture(const vk::raii::Device& device, 
             const vk::raii::PhysicalDevice& physicalDevice, 
             const vk::raii::CommandPool& commandPool, 
             const vk::raii::Queue& queue, 
-            const std::string& path);
+            const std::string& path,
+            ObjectCache* cache = nullptr);
 
     // Getters for the main application to use in Descriptor Sets
     const vk::raii::Image& getImage() const { return image; }
     const vk::raii::DeviceMemory& getMemory() const { return imageMemory; }
 
     const vk::raii::ImageView& getView() const { return imageView; }
-    const vk::raii::Sampler& getSampler() const { return sampler; }
+    vk::Sampler getSampler() const { return sampler; }
 
 private:
     vk::raii::Image image = nullptr;
     vk::raii::DeviceMemory imageMemory = nullptr;
     vk::raii::ImageView imageView = nullptr;
-    vk::raii::Sampler sampler = nullptr;
+    vk::raii::Sampler ownedSampler = nullptr;  // only without a cache
+    vk::Sampler sampler;
 
     // Internal Helpers
-    uint32_t findMemoryType(const vk::raii::PhysicalDevice& physicalDevice, uint32_t typeFilter, vk::MemoryPropertyFlags properties);
-    
     void transitionImageLayout(const vk::raii::Device& device, const vk::raii::CommandPool& commandPool, 
                                const vk::raii::Queue& queue, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
     
@@ -0,0 +1,516 @@
+// Headless benchmark for the renderer subsystems. Runs without a window or swapchain,
+// so it works on lavapipe in CI, and writes its results as JSON.
+//
+//   TriangleBench [--instances 10,100,1000] [--frames 200] [--warmup 10] [--iterations 20]
+//                 [--device <name substring>] [--texture <image>] [--model <gltf>]
+//                 [--output <results.json>]
+//
+// Asset paths are relative to the working directory, like Triangle; run it from the
+// repository root.
+
+#include "Scene.h"
+#include "Texture.h"
+#include "Model.h"
+#include "stb_image.h"
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct BenchOptions {
+    std::vector<uint32_t> instanceCounts = {10, 100, 1000, 10000}; // --instances <n,n,...>
+    uint32_t frames = 200;          // --frames <n>, timed frames per instance count
+    uint32_t warmupFrames = 10;     // --warmup <n>
+    uint32_t iterations = 20;       // --iterations <n>, for the decode/upload and pipeline cases
+    std::string devicePattern;      // --device <substring>, default prefers a CPU device (lavapipe)
+    std::string texturePath = "textures/texture.jpg";
+    std::string modelPath = "models/Cube/Cube.gltf";
+    std::string outputPath;         // --output <file>, default stdout
+};
+
+namespace {
+    double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        return values[index];
+    }
+
+    double elapsedMs(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    std::string jsonString(const std::string& value) {
+        std::string out = "\"";
+        for (char c : value) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) out += c;
+        }
+        return out + "\"";
+    }
+
+    std::string jsonSummary(const std::vector<double>& values) {
+        double sum = 0.0;
+        for (double v : values) sum += v;
+        double mean = values.empty() ? 0.0 : sum / values.size();
+
+        std::ostringstream out;
+        out << "{\"min\": " << percentile(values, 0.0) << ", \"mean\": " << mean
+            << ", \"p50\": " << percentile(values, 0.5) << ", \"p95\": " << percentile(values, 0.95)
+            << ", \"max\": " << percentile(values, 1.0) << "}";
+        return out.str();
+    }
+
+    std::vector<uint32_t> parseCounts(const std::string& list) {
+        std::vector<uint32_t> counts;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            uint32_t count = static_cast<uint32_t>(std::stoul(item));
+            if (count == 0) throw std::runtime_error("instance counts must be positive!");
+            counts.push_back(count);
+        }
+        return counts;
+    }
+}
+
+class TriangleBench {
+public:
+    explicit TriangleBench(BenchOptions options) : options(std::move(options)) {}
+
+    void run() {
+        initVulkan();
+
+        benchImageDecodeUpload();
+        benchPipelineCreation();
+        for (uint32_t instances : options.instanceCounts) {
+            benchTransformUpdate(instances);
+            benchFrameLoop(instances);
+        }
+        device.waitIdle();
+
+        if (options.outputPath.empty()) {
+            writeResults(std::cout);
+        } else {
+            std::ofstream file(options.outputPath, std::ios::trunc);
+            if (!file.is_open()) throw std::runtime_error("failed to open output file: " + options.outputPath);
+            writeResults(file);
+            std::cerr << "Results written to " << options.outputPath << std::endl;
+        }
+    }
+
+private:
+    // Offscreen target; same size as Triangle's window
+    const vk::Extent2D extent{800, 600};
+    const vk::Format colorFormat = vk::Format::eR8G8B8A8Unorm;
+
+    BenchOptions options;
+
+    vk::raii::Context context;
+    vk::raii::Instance instance = nullptr;
+    vk::raii::PhysicalDevice physicalDevice = nullptr;
+    vk::raii::Device device = nullptr;
+    vk::raii::Queue queue = nullptr;
+    uint32_t queueFamilyIndex = 0;
+    float timestampPeriod = 0.0f;
+    uint64_t timestampMask = 0;      // low timestampValidBits of the queue family
+
+    vk::raii::CommandPool commandPool = nullptr;
+    vk::raii::CommandBuffers commandBuffers = nullptr;
+    vk::raii::Fence fence = nullptr;
+    vk::raii::QueryPool queryPool = nullptr;
+
+    vk::SampleCountFlagBits msaaSamples = vk::SampleCountFlagBits::e1;
+    vk::Format depthFormat = vk::Format::eUndefined;
+    vk::raii::Image colorImage = nullptr;
+    vk::raii::DeviceMemory colorImageMemory = nullptr;
+    vk::raii::ImageView colorImageView = nullptr;
+    vk::raii::Image depthImage = nullptr;
+    vk::raii::DeviceMemory depthImageMemory = nullptr;
+    vk::raii::ImageView depthImageView = nullptr;
+    vk::raii::Image resolveImage = nullptr;
+    vk::raii::DeviceMemory resolveImageMemory = nullptr;
+    vk::raii::ImageView resolveImageView = nullptr;
+
+    vk::raii::RenderPass renderPass = nullptr;
+    vk::raii::Framebuffer framebuffer = nullptr;
+    vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
+    vk::raii::PipelineLayout pipelineLayout = nullptr;
+    vk::raii::Pipeline pipeline = nullptr;
+    std::vector<char> vertCode;
+    std::vector<char> fragCode;
+
+    std::unique_ptr<Texture> texture;
+    std::unique_ptr<Model> model;
+
+    std::vector<std::string> results;   // one JSON object per case
+
+    // --- 1. SETUP ---
+
+    void initVulkan() {
+        createInstance();
+        pickPhysicalDevice();
+        createLogicalDevice();
+
+        vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, queueFamilyIndex);
+        commandPool = vk::raii::CommandPool(device, poolInfo);
+        commandBuffers = vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo(*commandPool, vk::CommandBufferLevel::ePrimary, 1));
+        fence = vk::raii::Fence(device, vk::FenceCreateInfo{});
+        if (timestampPeriod > 0.0f) {
+            queryPool = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, 2));
+        }
+
+        createRenderTargets();
+        renderPass = createSceneRenderPass(device, colorFormat, depthFormat, msaaSamples, vk::ImageLayout::eColorAttachmentOptimal);
+        std::array<vk::ImageView, 3> attachments = {*colorImageView, *depthImageView, *resolveImageView};
+        framebuffer = vk::raii::Framebuffer(device, vk::FramebufferCreateInfo({}, *renderPass, static_cast<uint32_t>(attachments.size()),
+            attachments.data(), extent.width, extent.height, 1));
+
+        // Binding 0 is dynamic so every batch of kSceneBatchSize instances gets its own uniform block
+        std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+            vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex),
+            vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment)
+        };
+        descriptorSetLayout = vk::raii::DescriptorSetLayout(device, vk::DescriptorSetLayoutCreateInfo({}, static_cast<uint32_t>(bindings.size()), bindings.data()));
+        pipelineLayout = vk::raii::PipelineLayout(device, vk::PipelineLayoutCreateInfo({}, 1, &*descriptorSetLayout));
+
+        vertCode = readShaderFile("shaders/vert.spv");
+        fragCode = readShaderFile("shaders/frag.spv");
+        pipeline = createScenePipeline(device, vertCode, fragCode, *pipelineLayout, *renderPass, extent, msaaSamples);
+
+        model = std::make_unique<Model>(device, physicalDevice, commandPool, queue, options.modelPath);
+    }
+
+    void createInstance() {
+        vk::ApplicationInfo appInfo("Triangle Bench", VK_MAKE_VERSION(1, 0, 0), "No Engine", VK_MAKE_VERSION(1, 0, 0), VK_API_VERSION_1_3);
+
+        std::vector<const char*> extensions;
+        vk::InstanceCreateFlags flags{};
+        for (const auto& ext : context.enumerateInstanceExtensionProperties()) {
+            if (std::string(ext.extensionName.data()) == VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME) {
+                extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+                flags |= vk::InstanceCreateFlagBits::eEnumeratePortabilityKHR;
+            }
+        }
+
+        vk::InstanceCreateInfo createInfo(flags, &appInfo, 0, nullptr, static_cast<uint32_t>(extensions.size()), extensions.data());
+        instance = vk::raii::Instance(context, createInfo);
+    }
+
+    void pickPhysicalDevice() {
+        vk::raii::PhysicalDevices devices(instance);
+        if (devices.empty()) throw std::runtime_error("no Vulkan devices found!");
+
+        for (const auto& dev : devices) {
+            auto props = dev.getProperties();
+            std::string name = props.deviceName.data();
+            bool match = options.devicePattern.empty() ? props.deviceType == vk::PhysicalDeviceType::eCpu
+                                                       : name.find(options.devicePattern) != std::string::npos;
+            if (match) { physicalDevice = dev; break; }
+        }
+        if (*physicalDevice == nullptr) {
+            if (!options.devicePattern.empty()) throw std::runtime_error("no device matches: " + options.devicePattern);
+            physicalDevice = devices[0];
+        }
+
+        std::cerr << "Selected GPU: " << physicalDevice.getProperties().deviceName << std::endl;
+    }
+
+    void createLogicalDevice() {
+        auto queueFamilies = physicalDevice.getQueueFamilyProperties();
+        bool found = false;
+        for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+            if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics) {
+                queueFamilyIndex = i; found = true;
+                break;
+            }
+        }
+        if (!found) throw std::runtime_error("device has no graphics queue!");
+
+        uint32_t timestampValidBits = queueFamilies[queueFamilyIndex].timestampValidBits;
+        if (timestampValidBits != 0) {
+            timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+            timestampMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+        }
+
+        std::vector<const char*> extensions;
+        for (const auto& ext : physicalDevice.enumerateDeviceExtensionProperties()) {
+            if (std::string(ext.extensionName.data()) == "VK_KHR_portability_subset") extensions.push_back("VK_KHR_portability_subset");
+        }
+
+        float priority = 1.0f;
+        vk::DeviceQueueCreateInfo queueInfo({}, queueFamilyIndex, 1, &priority);
+        vk::DeviceCreateInfo createInfo({}, queueInfo, {}, extensions);
+        device = vk::raii::Device(physicalDevice, createInfo);
+        queue = vk::raii::Queue(device, queueFamilyIndex, 0);
+    }
+
+    void createRenderTargets() {
+        for (vk::Format format : {vk::Format::eD32Sfloat, vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint}) {
+            if (physicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment) {
+                depthFormat = format;
+                break;
+            }
+        }
+        if (depthFormat == vk::Format::eUndefined) throw std::runtime_error("failed to find supported depth format!");
+
+        // Match Triangle's 4x MSAA where the device allows it
+        auto limits = physicalDevice.getProperties().limits;
+        if (limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts & vk::SampleCountFlagBits::e4) {
+            msaaSamples = vk::SampleCountFlagBits::e4;
+        }
+
+        createImage(colorFormat, msaaSamples, vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment,
+            vk::ImageAspectFlagBits::eColor, colorImage, colorImageMemory, colorImageView);
+        createImage(depthFormat, msaaSamples, vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment,
+            vk::ImageAspectFlagBits::eDepth, depthImage, depthImageMemory, depthImageView);
+        createImage(colorFormat, vk::SampleCountFlagBits::e1, vk::ImageUsageFlagBits::eColorAttachment,
+            vk::ImageAspectFlagBits::eColor, resolveImage, resolveImageMemory, resolveImageView);
+    }
+
+    // --- 2. CASES ---
+
+    // Decode alone, then decode + staging upload + sampler as Triangle does at startup
+    void benchImageDecodeUpload() {
+        std::vector<double> decodeMs, uploadMs;
+        for (uint32_t i = 0; i < options.iterations; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            int texWidth, texHeight, texChannels;
+            stbi_uc* pixels = stbi_load(options.texturePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+            if (!pixels) throw std::runtime_error("failed to load texture image: " + options.texturePath);
+            stbi_image_free(pixels);
+            decodeMs.push_back(elapsedMs(start));
+
+            start = std::chrono::high_resolution_clock::now();
+            texture = std::make_unique<Texture>(device, physicalDevice, commandPool, queue, options.texturePath);
+            uploadMs.push_back(elapsedMs(start));
+        }
+
+        addResult("image_decode", 0, options.iterations, {{"cpu_ms", decodeMs}});
+        addResult("image_decode_upload", 0, options.iterations, {{"cpu_ms", uploadMs}});
+    }
+
+    void benchPipelineCreation() {
+        std::vector<double> createMs;
+        for (uint32_t i = 0; i < options.iterations; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            vk::raii::Pipeline created = createScenePipeline(device, vertCode, fragCode, *pipelineLayout, *renderPass, extent, msaaSamples);
+            createMs.push_back(elapsedMs(start));
+        }
+
+        addResult("pipeline_creation", 0, options.iterations, {{"cpu_ms", createMs}});
+    }
+
+    // CPU cost of rebuilding every instance's model matrix for one frame
+    void benchTransformUpdate(uint32_t instances) {
+        std::vector<glm::mat4> models(instances);
+        std::vector<double> updateMs;
+        for (uint32_t frame = 0; frame < options.frames; frame++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            updateInstanceTransforms(models.data(), 0, instances, frame / 60.0f);
+            updateMs.push_back(elapsedMs(start));
+        }
+
+        addResult("instance_transform_update", instances, options.frames, {{"cpu_ms", updateMs}});
+    }
+
+    // Full frames into the offscreen target: transform update + uniform upload, recording,
+    // submission, and the wait for completion. One frame in flight, as in Triangle.
+    void benchFrameLoop(uint32_t instances) {
+        uint32_t batches = (instances + kSceneBatchSize - 1) / kSceneBatchSize;
+        vk::DeviceSize alignment = physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+        vk::DeviceSize stride = (sizeof(SceneUniforms) + alignment - 1) / alignment * alignment;
+
+        vk::raii::Buffer uniformBuffer = nullptr;
+        vk::raii::DeviceMemory uniformMemory = nullptr;
+        createBuffer(device, physicalDevice, stride * batches, vk::BufferUsageFlagBits::eUniformBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, uniformBuffer, uniformMemory);
+        auto* mapped = static_cast<char*>(uniformMemory.mapMemory(0, stride * batches));
+
+        std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+            vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, 1),
+            vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 1)
+        };
+        vk::raii::DescriptorPool descriptorPool(device, vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, 1,
+            static_cast<uint32_t>(poolSizes.size()), poolSizes.data()));
+        vk::raii::DescriptorSets descriptorSets(device, vk::DescriptorSetAllocateInfo(*descriptorPool, *descriptorSetLayout));
+
+        vk::DescriptorBufferInfo bufferInfo(*uniformBuffer, 0, sizeof(SceneUniforms));
+        vk::DescriptorImageInfo imageInfo(texture->getSampler(), *texture->getView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+        std::array<vk::WriteDescriptorSet, 2> writes = {
+            vk::WriteDescriptorSet(*descriptorSets[0], 0, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &bufferInfo),
+            vk::WriteDescriptorSet(*descriptorSets[0], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &imageInfo)
+        };
+        device.updateDescriptorSets(writes, nullptr);
+
+        SceneUniforms camera{};
+        updateSceneCamera(camera, glm::vec3(5.0f, 5.0f, 5.0f), extent);
+
+        std::array<vk::ClearValue, 3> clearValues{};
+        clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
+        clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+        clearValues[2].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
+
+        const auto& commandBuffer = commandBuffers[0];
+        std::vector<double> cpuMs, frameMs, gpuMs;
+
+        for (uint32_t frame = 0; frame < options.warmupFrames + options.frames; frame++) {
+            auto frameStart = std::chrono::high_resolution_clock::now();
+
+            for (uint32_t batch = 0; batch < batches; batch++) {
+                SceneUniforms& ubo = *reinterpret_cast<SceneUniforms*>(mapped + batch * stride);
+                uint32_t first = batch * kSceneBatchSize;
+                updateInstanceTransforms(ubo.models, first, std::min(kSceneBatchSize, instances - first), frame / 60.0f);
+                ubo.view = camera.view;
+                ubo.proj = camera.proj;
+            }
+
+            commandBuffer.reset();
+            commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+            if (timestampPeriod > 0.0f) {
+                commandBuffer.resetQueryPool(*queryPool, 0, 2);
+                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
+            }
+
+            vk::RenderPassBeginInfo renderPassInfo(*renderPass, *framebuffer, vk::Rect2D({0, 0}, extent),
+                static_cast<uint32_t>(clearValues.size()), clearValues.data());
+            commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+            commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *pipeline);
+            vk::Buffer vertexBuffers[] = {*model->getVertexBuffer()};
+            vk::DeviceSize offsets[] = {0};
+            commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+            commandBuffer.bindIndexBuffer(*model->getIndexBuffer(), 0, vk::IndexType::eUint32);
+            for (uint32_t batch = 0; batch < batches; batch++) {
+                uint32_t dynamicOffset = static_cast<uint32_t>(batch * stride);
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *descriptorSets[0], dynamicOffset);
+                commandBuffer.drawIndexed(model->getIndexCount(), std::min(kSceneBatchSize, instances - batch * kSceneBatchSize), 0, 0, 0);
+            }
+            commandBuffer.endRenderPass();
+
+            if (timestampPeriod > 0.0f) {
+                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
+            }
+            commandBuffer.end();
+
+            vk::SubmitInfo submitInfo({}, {}, *commandBuffer, {});
+            queue.submit(submitInfo, *fence);
+            double cpu = elapsedMs(frameStart);
+
+            (void)device.waitForFences(*fence, VK_TRUE, UINT64_MAX);
+            device.resetFences(*fence);
+            double total = elapsedMs(frameStart);
+
+            double gpu = 0.0;
+            if (timestampPeriod > 0.0f) {
+                auto [result, timestamps] = queryPool.getResults<uint64_t>(0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t),
+                    vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+                // Bits above timestampValidBits are undefined, and the counter may wrap within a frame
+                uint64_t ticks = ((timestamps[1] & timestampMask) - (timestamps[0] & timestampMask)) & timestampMask;
+                if (result == vk::Result::eSuccess) gpu = ticks * timestampPeriod / 1.0e6;
+            }
+
+            if (frame < options.warmupFrames) continue;
+            cpuMs.push_back(cpu);
+            frameMs.push_back(total);
+            gpuMs.push_back(gpu);
+        }
+
+        uniformMemory.unmapMemory();
+        addResult("frame_loop", instances, options.frames, {{"cpu_ms", cpuMs}, {"frame_ms", frameMs}, {"gpu_ms", gpuMs}});
+    }
+
+    // --- 3. OUTPUT ---
+
+    void addResult(const std::string& name, uint32_t instances, uint32_t samples,
+                   const std::vector<std::pair<std::string, std::vector<double>>>& timings) {
+        std::ostringstream out;
+        out << "{\"name\": " << jsonString(name);
+        if (instances) out << ", \"instances\": " << instances;
+        out << ", \"samples\": " << samples;
+        for (const auto& [key, values] : timings) out << ", " << jsonString(key) << ": " << jsonSummary(values);
+        out << "}";
+        results.push_back(out.str());
+
+        std::cerr << name;
+        if (instances) std::cerr << " (" << instances << " instances)";
+        std::cerr << ": median " << timings[0].first << " " << percentile(timings[0].second, 0.5) << std::endl;
+    }
+
+    void writeResults(std::ostream& out) {
+        auto props = physicalDevice.getProperties();
+        out << "{\n"
+            << "  \"device\": {\"name\": " << jsonString(props.deviceName.data())
+            << ", \"type\": " << jsonString(vk::to_string(props.deviceType))
+            << ", \"apiVersion\": \"" << VK_API_VERSION_MAJOR(props.apiVersion) << "." << VK_API_VERSION_MINOR(props.apiVersion)
+            << "." << VK_API_VERSION_PATCH(props.apiVersion) << "\", \"driverVersion\": " << props.driverVersion << "},\n"
+            << "  \"config\": {\"width\": " << extent.width << ", \"height\": " << extent.height
+            << ", \"samples\": " << static_cast<uint32_t>(msaaSamples) << ", \"batchSize\": " << kSceneBatchSize
+            << ", \"frames\": " << options.frames << ", \"warmupFrames\": " << options.warmupFrames
+            << ", \"iterations\": " << options.iterations << ", \"gpuTimestamps\": " << (timestampPeriod > 0.0f ? "true" : "false") << "},\n"
+            << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            out << "    " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}" << std::endl;
+    }
+
+    // --- 4. HELPERS ---
+
+    void createImage(vk::Format format, vk::SampleCountFlagBits samples, vk::ImageUsageFlags usage, vk::ImageAspectFlags aspect,
+                     vk::raii::Image& image, vk::raii::DeviceMemory& memory, vk::raii::ImageView& view) {
+        vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, format, {extent.width, extent.height, 1}, 1, 1,
+            samples, vk::ImageTiling::eOptimal, usage, vk::SharingMode::eExclusive);
+        image = vk::raii::Image(device, imageInfo);
+
+        // Transient attachments get lazily allocated memory where available, as in Triangle
+        bool lazy = false;
+        memory = allocateAttachmentMemory(device, physicalDevice, image.getMemoryRequirements(),
+            static_cast<bool>(usage & vk::ImageUsageFlagBits::eTransientAttachment), lazy);
+        image.bindMemory(*memory, 0);
+
+        view = vk::raii::ImageView(device, vk::ImageViewCreateInfo({}, *image, vk::ImageViewType::e2D, format, {}, {aspect, 0, 1, 0, 1}));
+    }
+};
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) { std::cerr << "missing value for " << arg << std::endl; return EXIT_FAILURE; }
+            std::string value = argv[++i];
+            if (arg == "--instances") options.instanceCounts = parseCounts(value);
+            else if (arg == "--frames") options.frames = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--warmup") options.warmupFrames = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--iterations") options.iterations = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--device") options.devicePattern = value;
+            else if (arg == "--texture") options.texturePath = value;
+            else if (arg == "--model") options.modelPath = value;
+            else if (arg == "--output") options.outputPath = value;
+            else { std::cerr << "unknown option: " << arg << std::endl; return EXIT_FAILURE; }
+        }
+        if (options.iterations == 0 || options.frames == 0) throw std::runtime_error("--frames and --iterations must be positive!");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    TriangleBench bench(std::move(options));
+    try { bench.run(); }
+    catch (const std::exception& e) { std::cerr << e.what() << std::endl; return EXIT_FAILURE; }
+    return EXIT_SUCCESS;
+}
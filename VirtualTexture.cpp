@@ -0,0 +1,467 @@
+#include "VirtualTexture.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    // Upload barriers: either into eTransferDstOptimal for a copy, or back to shader reads
+    void transitionForUpload(const vk::raii::CommandBuffer& commandBuffer, vk::Image image, uint32_t mipLevels,
+                             vk::ImageLayout oldLayout, vk::ImageLayout newLayout) {
+        vk::ImageMemoryBarrier barrier({}, {}, oldLayout, newLayout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image,
+            {vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1});
+
+        vk::PipelineStageFlags sourceStage, destinationStage;
+
+        if (newLayout == vk::ImageLayout::eTransferDstOptimal) {
+            // Only a WAR hazard against last frame's sampling, so no source access is needed
+            barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+            sourceStage = oldLayout == vk::ImageLayout::eUndefined ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eFragmentShader;
+            destinationStage = vk::PipelineStageFlagBits::eTransfer;
+        } else {
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+            sourceStage = vk::PipelineStageFlagBits::eTransfer;
+            destinationStage = vk::PipelineStageFlagBits::eFragmentShader;
+        }
+
+        commandBuffer.pipelineBarrier(sourceStage, destinationStage, {}, {}, {}, barrier);
+    }
+}
+
+VirtualTexture::VirtualTexture(const vk::raii::Device& device,
+                               const vk::raii::PhysicalDevice& physicalDevice,
+                               const vk::raii::CommandPool& commandPool,
+                               const vk::raii::Queue& queue,
+                               const std::string& pageFilePath,
+                               vk::Extent2D renderExtent,
+                               vk::Format depthFormat,
+                               ObjectCache& cache,
+                               uint32_t cachePagesPerSide)
+    : pageFile(pageFilePath), header(pageFile.getHeader()), tileSize(pageFile.getTileSize()),
+      tileBytes(pageFile.getTileBytes()), cachePagesPerSide(cachePagesPerSide) {
+
+    if (pageFile.getPagesX(0) > 0xFFF || pageFile.getPagesY(0) > 0xFFF || header.mipCount > 0xFF) {
+        throw std::runtime_error("virtual texture too large for the feedback encoding: " + pageFilePath);
+    }
+    // A frame's uploads must never evict each other, so the cache holds well over kMaxUploadsPerFrame pages
+    if (cachePagesPerSide < 8 || cachePagesPerSide > 256) {
+        throw std::runtime_error("virtual texture cache must be between 8 and 256 pages per side!");
+    }
+
+    feedbackExtent = vk::Extent2D(std::max(1u, renderExtent.width / kFeedbackDivisor), std::max(1u, renderExtent.height / kFeedbackDivisor));
+
+    createCache(device, physicalDevice, cache);
+    createIndirection(device, physicalDevice, cache);
+    createFeedbackResources(device, physicalDevice, depthFormat);
+
+    slots.resize(size_t(cachePagesPerSide) * cachePagesPerSide);
+    for (uint32_t i = static_cast<uint32_t>(slots.size()); i > 0; i--) freeSlots.push_back(i - 1);
+
+    loadPinnedPages(device, commandPool, queue);
+
+    streamThread = std::thread(&VirtualTexture::streamLoop, this, pageFilePath);
+}
+
+VirtualTexture::~VirtualTexture() {
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        stopStreaming = true;
+    }
+    streamCv.notify_all();
+    if (streamThread.joinable()) streamThread.join();
+}
+
+void VirtualTexture::createCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, ObjectCache& cache) {
+    uint32_t cacheSize = cachePagesPerSide * tileSize;
+
+    vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, vk::Format::eR8G8B8A8Srgb,
+        {cacheSize, cacheSize, 1}, 1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled);
+    cacheImage = vk::raii::Image(device, imageInfo);
+
+    vk::MemoryRequirements memReq = cacheImage.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    cacheMemory = vk::raii::DeviceMemory(device, allocInfo);
+    cacheImage.bindMemory(*cacheMemory, 0);
+    allocatedBytes += memReq.size;
+
+    vk::ImageViewCreateInfo viewInfo({}, *cacheImage, vk::ImageViewType::e2D, vk::Format::eR8G8B8A8Srgb, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    cacheView = vk::raii::ImageView(device, viewInfo);
+
+    // Tile borders absorb the bilinear footprint, so clamping only matters at the atlas edge
+    vk::SamplerCreateInfo samplerInfo({}, vk::Filter::eLinear, vk::Filter::eLinear,
+        vk::SamplerMipmapMode::eNearest, vk::SamplerAddressMode::eClampToEdge,
+        vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge,
+        0.0f, VK_FALSE, 1.0f, VK_FALSE, vk::CompareOp::eAlways, 0.0f, 0.0f,
+        vk::BorderColor::eIntOpaqueBlack, VK_FALSE);
+    cacheSampler = cache.getSampler(samplerInfo);
+}
+
+void VirtualTexture::createIndirection(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, ObjectCache& cache) {
+    vk::DeviceSize indirectionBytes = 0;
+    indirection.resize(header.mipCount);
+    for (uint32_t mip = 0; mip < header.mipCount; mip++) {
+        indirection[mip].assign(size_t(pageFile.getPagesX(mip)) * pageFile.getPagesY(mip), 0);
+        indirectionBytes += indirection[mip].size() * sizeof(uint32_t);
+    }
+
+    vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, vk::Format::eR8G8B8A8Unorm,
+        {pageFile.getPagesX(0), pageFile.getPagesY(0), 1}, header.mipCount, 1,
+        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled);
+    indirectionImage = vk::raii::Image(device, imageInfo);
+
+    vk::MemoryRequirements memReq = indirectionImage.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    indirectionMemory = vk::raii::DeviceMemory(device, allocInfo);
+    indirectionImage.bindMemory(*indirectionMemory, 0);
+    allocatedBytes += memReq.size;
+
+    vk::ImageViewCreateInfo viewInfo({}, *indirectionImage, vk::ImageViewType::e2D, vk::Format::eR8G8B8A8Unorm, {}, {vk::ImageAspectFlagBits::eColor, 0, header.mipCount, 0, 1});
+    indirectionView = vk::raii::ImageView(device, viewInfo);
+
+    vk::SamplerCreateInfo samplerInfo({}, vk::Filter::eNearest, vk::Filter::eNearest,
+        vk::SamplerMipmapMode::eNearest, vk::SamplerAddressMode::eRepeat,
+        vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat,
+        0.0f, VK_FALSE, 1.0f, VK_FALSE, vk::CompareOp::eAlways, 0.0f, static_cast<float>(header.mipCount - 1),
+        vk::BorderColor::eIntOpaqueBlack, VK_FALSE);
+    indirectionSampler = cache.getSampler(samplerInfo);
+
+    // One staging region for this frame's tiles, followed by the full indirection chain
+    vk::DeviceSize stagingSize = kMaxUploadsPerFrame * tileBytes + indirectionBytes;
+    vk::BufferCreateInfo stagingInfo({}, stagingSize, vk::BufferUsageFlagBits::eTransferSrc);
+    stagingBuffer = vk::raii::Buffer(device, stagingInfo);
+
+    vk::MemoryRequirements stagingReq = stagingBuffer.getMemoryRequirements();
+    vk::MemoryAllocateInfo stagingAlloc(stagingReq.size,
+        findMemoryType(physicalDevice, stagingReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent));
+    stagingMemory = vk::raii::DeviceMemory(device, stagingAlloc);
+    stagingBuffer.bindMemory(*stagingMemory, 0);
+    stagingMapped = static_cast<uint8_t*>(stagingMemory.mapMemory(0, stagingSize));
+}
+
+void VirtualTexture::createFeedbackResources(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, vk::Format depthFormat) {
+    // 1. Page request target
+    vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, vk::Format::eR32Uint,
+        {feedbackExtent.width, feedbackExtent.height, 1}, 1, 1,
+        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc);
+    feedbackImage = vk::raii::Image(device, imageInfo);
+
+    vk::MemoryRequirements memReq = feedbackImage.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    feedbackMemory = vk::raii::DeviceMemory(device, allocInfo);
+    feedbackImage.bindMemory(*feedbackMemory, 0);
+
+    vk::ImageViewCreateInfo viewInfo({}, *feedbackImage, vk::ImageViewType::e2D, vk::Format::eR32Uint, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+    feedbackView = vk::raii::ImageView(device, viewInfo);
+
+    // 2. Depth, so hidden surfaces don't request pages
+    vk::ImageCreateInfo depthInfo({}, vk::ImageType::e2D, depthFormat,
+        {feedbackExtent.width, feedbackExtent.height, 1}, 1, 1,
+        vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+        vk::ImageUsageFlagBits::eDepthStencilAttachment);
+    feedbackDepthImage = vk::raii::Image(device, depthInfo);
+
+    vk::MemoryRequirements depthReq = feedbackDepthImage.getMemoryRequirements();
+    vk::MemoryAllocateInfo depthAlloc(depthReq.size, findMemoryType(physicalDevice, depthReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    feedbackDepthMemory = vk::raii::DeviceMemory(device, depthAlloc);
+    feedbackDepthImage.bindMemory(*feedbackDepthMemory, 0);
+
+    vk::ImageViewCreateInfo depthViewInfo({}, *feedbackDepthImage, vk::ImageViewType::e2D, depthFormat, {}, {vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1});
+    feedbackDepthView = vk::raii::ImageView(device, depthViewInfo);
+
+    // 3. Render pass that leaves the requests ready for the readback copy
+    vk::AttachmentDescription colorAttachment({}, vk::Format::eR32Uint, vk::SampleCountFlagBits::e1,
+        vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore,
+        vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+        vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferSrcOptimal);
+    vk::AttachmentDescription depthAttachment({}, depthFormat, vk::SampleCountFlagBits::e1,
+        vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare,
+        vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+        vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
+    vk::AttachmentReference depthRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
+
+    vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorRef, nullptr, &depthRef);
+    std::array<vk::AttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+
+    std::array<vk::SubpassDependency, 2> dependencies = {
+        // Last frame's readback must finish before the target is cleared again
+        vk::SubpassDependency(VK_SUBPASS_EXTERNAL, 0,
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests,
+            {}, vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite),
+        vk::SubpassDependency(0, VK_SUBPASS_EXTERNAL,
+            vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+            vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead)
+    };
+
+    vk::RenderPassCreateInfo renderPassInfo({}, static_cast<uint32_t>(attachments.size()), attachments.data(), 1, &subpass,
+        static_cast<uint32_t>(dependencies.size()), dependencies.data());
+    feedbackRenderPass = vk::raii::RenderPass(device, renderPassInfo);
+
+    std::array<vk::ImageView, 2> views = {*feedbackView, *feedbackDepthView};
+    vk::FramebufferCreateInfo fbInfo({}, *feedbackRenderPass, static_cast<uint32_t>(views.size()), views.data(), feedbackExtent.width, feedbackExtent.height, 1);
+    feedbackFramebuffer = vk::raii::Framebuffer(device, fbInfo);
+
+    // 4. Host readback buffer
+    vk::DeviceSize readbackSize = vk::DeviceSize(feedbackExtent.width) * feedbackExtent.height * sizeof(uint32_t);
+    vk::BufferCreateInfo readbackInfo({}, readbackSize, vk::BufferUsageFlagBits::eTransferDst);
+    readbackBuffer = vk::raii::Buffer(device, readbackInfo);
+
+    vk::MemoryRequirements readbackReq = readbackBuffer.getMemoryRequirements();
+    vk::MemoryAllocateInfo readbackAlloc(readbackReq.size,
+        findMemoryType(physicalDevice, readbackReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent));
+    readbackMemory = vk::raii::DeviceMemory(device, readbackAlloc);
+    readbackBuffer.bindMemory(*readbackMemory, 0);
+    readbackMapped = static_cast<const uint32_t*>(readbackMemory.mapMemory(0, readbackSize));
+}
+
+void VirtualTexture::loadPinnedPages(const vk::raii::Device& device, const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue) {
+    // The coarsest mip always fits in a single page and backs every fallback lookup
+    uint32_t coarsest = header.mipCount - 1;
+    std::vector<uint8_t> pixels(tileBytes);
+    pageFile.readPage(coarsest, 0, 0, pixels.data());
+    stagePage(packPage(coarsest, 0, 0), pixels.data(), 0, true);
+
+    vk::CommandBufferAllocateInfo allocInfo(*commandPool, vk::CommandBufferLevel::ePrimary, 1);
+    vk::raii::CommandBuffers cb(device, allocInfo);
+    vk::raii::CommandBuffer commandBuffer = std::move(cb[0]);
+
+    commandBuffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+    recordUploads(commandBuffer, vk::ImageLayout::eUndefined);
+    commandBuffer.end();
+
+    vk::SubmitInfo submitInfo({}, {}, *commandBuffer, {});
+    queue.submit(submitInfo, nullptr);
+    queue.waitIdle();
+}
+
+VirtualTextureParams VirtualTexture::getParams(bool forFeedback) const {
+    float cacheSize = static_cast<float>(cachePagesPerSide * tileSize);
+    VirtualTextureParams params{};
+    params.virtualSize[0] = static_cast<float>(header.width);
+    params.virtualSize[1] = static_cast<float>(header.height);
+    params.cacheSize[0] = cacheSize;
+    params.cacheSize[1] = cacheSize;
+    params.pageSize = static_cast<float>(header.pageSize);
+    params.border = static_cast<float>(header.border);
+    params.maxMip = static_cast<float>(header.mipCount - 1);
+    // Derivatives in the feedback pass are kFeedbackDivisor times larger than on screen
+    params.feedbackBias = forFeedback ? -std::log2(static_cast<float>(kFeedbackDivisor)) : 0.0f;
+    return params;
+}
+
+VirtualTextureStats VirtualTexture::getStats() const {
+    VirtualTextureStats stats;
+    stats.residentPages = static_cast<uint32_t>(residentPages.size());
+    stats.cachePages = static_cast<uint32_t>(slots.size());
+    stats.pendingPages = static_cast<uint32_t>(pendingPages.size());
+    stats.residentBytes = residentPages.size() * tileBytes;
+    stats.allocatedBytes = allocatedBytes;
+    for (uint32_t mip = 0; mip < header.mipCount; mip++) {
+        stats.fullChainBytes += vk::DeviceSize(std::max(1u, header.width >> mip)) * std::max(1u, header.height >> mip) * 4;
+    }
+    stats.faultsLastFrame = faultsLastFrame;
+    stats.totalFaults = totalFaults;
+    stats.totalRequests = totalRequests;
+    stats.frames = frames;
+    return stats;
+}
+
+void VirtualTexture::processFeedback() {
+    if (!feedbackPending) return;
+    feedbackPending = false;
+    faultsLastFrame = 0;
+
+    std::unordered_set<uint32_t> requested;
+    size_t texelCount = size_t(feedbackExtent.width) * feedbackExtent.height;
+    for (size_t i = 0; i < texelCount; i++) {
+        if (readbackMapped[i] != kInvalidPage) requested.insert(readbackMapped[i]);
+    }
+
+    std::vector<uint32_t> misses;
+    for (uint32_t page : requested) {
+        uint32_t mip = pageMip(page);
+        if (mip >= header.mipCount || pageX(page) >= pageFile.getPagesX(mip) || pageY(page) >= pageFile.getPagesY(mip)) continue;
+
+        auto it = residentPages.find(page);
+        if (it != residentPages.end()) {
+            Slot& slot = slots[it->second];
+            if (!slot.pinned) lru.splice(lru.begin(), lru, slot.lruIt);
+            continue;
+        }
+
+        faultsLastFrame++;
+        if (pendingPages.insert(page).second) misses.push_back(page);
+    }
+
+    // Coarse pages first: they cover the most screen area and unblock refinement soonest
+    std::sort(misses.begin(), misses.end(), [](uint32_t a, uint32_t b) { return pageMip(a) > pageMip(b); });
+
+    totalRequests += requested.size();
+    totalFaults += faultsLastFrame;
+    frames++;
+
+    if (!misses.empty()) {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        streamRequests.insert(streamRequests.end(), misses.begin(), misses.end());
+    }
+    streamCv.notify_one();
+}
+
+void VirtualTexture::update(const vk::raii::CommandBuffer& commandBuffer) {
+    std::vector<StreamedPage> ready;
+    {
+        std::lock_guard<std::mutex> lock(streamMutex);
+        size_t count = std::min<size_t>(streamedPages.size(), kMaxUploadsPerFrame);
+        ready.assign(std::make_move_iterator(streamedPages.begin()), std::make_move_iterator(streamedPages.begin() + count));
+        streamedPages.erase(streamedPages.begin(), streamedPages.begin() + count);
+    }
+
+    uint32_t uploadIndex = 0;
+    for (const StreamedPage& page : ready) {
+        pendingPages.erase(page.page);
+        if (stagePage(page.page, page.pixels.data(), uploadIndex, false)) uploadIndex++;
+    }
+
+    recordUploads(commandBuffer, vk::ImageLayout::eShaderReadOnlyOptimal);
+}
+
+void VirtualTexture::recordFeedbackReadback(const vk::raii::CommandBuffer& commandBuffer) {
+    vk::BufferImageCopy region(0, 0, 0, {vk::ImageAspectFlagBits::eColor, 0, 0, 1}, {0, 0, 0}, {feedbackExtent.width, feedbackExtent.height, 1});
+    commandBuffer.copyImageToBuffer(*feedbackImage, vk::ImageLayout::eTransferSrcOptimal, *readbackBuffer, region);
+
+    vk::BufferMemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *readbackBuffer, 0, VK_WHOLE_SIZE);
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, barrier, {});
+
+    feedbackPending = true;
+}
+
+bool VirtualTexture::stagePage(uint32_t page, const uint8_t* pixels, uint32_t uploadIndex, bool pinned) {
+    if (residentPages.count(page)) return false;
+
+    uint32_t slotIndex = acquireSlot();
+    if (slotIndex == kInvalidPage) return false;
+
+    vk::DeviceSize offset = uploadIndex * tileBytes;
+    memcpy(stagingMapped + offset, pixels, tileBytes);
+
+    uint32_t slotX = slotIndex % cachePagesPerSide, slotY = slotIndex / cachePagesPerSide;
+    stagedCopies.emplace_back(offset, 0, 0, vk::ImageSubresourceLayers{vk::ImageAspectFlagBits::eColor, 0, 0, 1},
+        vk::Offset3D{static_cast<int32_t>(slotX * tileSize), static_cast<int32_t>(slotY * tileSize), 0}, vk::Extent3D{tileSize, tileSize, 1});
+
+    Slot& slot = slots[slotIndex];
+    slot.page = page;
+    slot.pinned = pinned;
+    if (!pinned) {
+        lru.push_front(slotIndex);
+        slot.lruIt = lru.begin();
+    }
+    residentPages[page] = slotIndex;
+    indirectionDirty = true;
+    return true;
+}
+
+uint32_t VirtualTexture::acquireSlot() {
+    if (!freeSlots.empty()) {
+        uint32_t slotIndex = freeSlots.back();
+        freeSlots.pop_back();
+        return slotIndex;
+    }
+    if (lru.empty()) return kInvalidPage;
+
+    // Evict the least recently requested page; its indirection entries fall back to an ancestor
+    uint32_t slotIndex = lru.back();
+    lru.pop_back();
+    residentPages.erase(slots[slotIndex].page);
+    slots[slotIndex].page = kInvalidPage;
+    return slotIndex;
+}
+
+void VirtualTexture::rebuildIndirection() {
+    for (uint32_t mip = header.mipCount; mip-- > 0;) {
+        uint32_t pagesX = pageFile.getPagesX(mip), pagesY = pageFile.getPagesY(mip);
+        bool hasParent = mip + 1 < header.mipCount;
+        uint32_t parentPagesX = hasParent ? pageFile.getPagesX(mip + 1) : 0;
+        uint32_t parentPagesY = hasParent ? pageFile.getPagesY(mip + 1) : 0;
+
+        for (uint32_t y = 0; y < pagesY; y++) {
+            for (uint32_t x = 0; x < pagesX; x++) {
+                uint32_t& entry = indirection[mip][size_t(y) * pagesX + x];
+                auto it = residentPages.find(packPage(mip, x, y));
+                if (it != residentPages.end()) {
+                    uint32_t slotX = it->second % cachePagesPerSide, slotY = it->second / cachePagesPerSide;
+                    entry = slotX | (slotY << 8) | (mip << 16) | (0xFFu << 24);
+                } else if (hasParent) {
+                    uint32_t px = std::min(x / 2, parentPagesX - 1), py = std::min(y / 2, parentPagesY - 1);
+                    entry = indirection[mip + 1][size_t(py) * parentPagesX + px];
+                }
+            }
+        }
+    }
+}
+
+void VirtualTexture::recordUploads(const vk::raii::CommandBuffer& commandBuffer, vk::ImageLayout oldLayout) {
+    bool initial = oldLayout == vk::ImageLayout::eUndefined;
+
+    if (!stagedCopies.empty() || initial) {
+        transitionForUpload(commandBuffer, *cacheImage, 1, oldLayout, vk::ImageLayout::eTransferDstOptimal);
+        if (!stagedCopies.empty()) {
+            commandBuffer.copyBufferToImage(*stagingBuffer, *cacheImage, vk::ImageLayout::eTransferDstOptimal, stagedCopies);
+        }
+        transitionForUpload(commandBuffer, *cacheImage, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+        stagedCopies.clear();
+    }
+
+    if (indirectionDirty || initial) {
+        rebuildIndirection();
+
+        std::vector<vk::BufferImageCopy> regions;
+        vk::DeviceSize offset = kMaxUploadsPerFrame * tileBytes;
+        for (uint32_t mip = 0; mip < header.mipCount; mip++) {
+            vk::DeviceSize size = indirection[mip].size() * sizeof(uint32_t);
+            memcpy(stagingMapped + offset, indirection[mip].data(), size);
+            regions.emplace_back(offset, 0, 0, vk::ImageSubresourceLayers{vk::ImageAspectFlagBits::eColor, mip, 0, 1},
+                vk::Offset3D{0, 0, 0}, vk::Extent3D{pageFile.getPagesX(mip), pageFile.getPagesY(mip), 1});
+            offset += size;
+        }
+
+        transitionForUpload(commandBuffer, *indirectionImage, header.mipCount, oldLayout, vk::ImageLayout::eTransferDstOptimal);
+        commandBuffer.copyBufferToImage(*stagingBuffer, *indirectionImage, vk::ImageLayout::eTransferDstOptimal, regions);
+        transitionForUpload(commandBuffer, *indirectionImage, header.mipCount, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+        indirectionDirty = false;
+    }
+}
+
+void VirtualTexture::streamLoop(std::string path) {
+    try {
+        PageFile file(path);
+        while (true) {
+            uint32_t page;
+            {
+                std::unique_lock<std::mutex> lock(streamMutex);
+                streamCv.wait(lock, [this] { return stopStreaming || !streamRequests.empty(); });
+                if (stopStreaming) return;
+                page = streamRequests.front();
+                streamRequests.pop_front();
+            }
+
+            StreamedPage loaded{page, std::vector<uint8_t>(tileBytes)};
+            file.readPage(pageMip(page), pageX(page), pageY(page), loaded.pixels.data());
+
+            std::lock_guard<std::mutex> lock(streamMutex);
+            streamedPages.push_back(std::move(loaded));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "virtual texture streaming stopped: " << e.what() << std::endl;
+    }
+}
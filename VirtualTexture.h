@@ -0,0 +1,185 @@
+#pragma once
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
+    #include <vulkan/vulkan_raii.hpp>
+#else
+    import vulkan_hpp;
+#endif
+
+#include "ObjectCache.h"
+#include "PageFile.h"
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Push constant block read by shaders/vt_feedback.frag and shaders/vt_shade.frag
+struct VirtualTextureParams {
+    float virtualSize[2];
+    float cacheSize[2];
+    float pageSize;
+    float border;
+    float maxMip;
+    float feedbackBias;
+};
+
+struct VirtualTextureStats {
+    uint32_t residentPages = 0;
+    uint32_t cachePages = 0;
+    uint32_t pendingPages = 0;
+    vk::DeviceSize residentBytes = 0;    // tiles currently holding page data
+    vk::DeviceSize allocatedBytes = 0;   // physical cache + indirection allocations
+    vk::DeviceSize fullChainBytes = 0;   // the same texture fully resident with all mips
+    uint32_t faultsLastFrame = 0;
+    uint64_t totalFaults = 0;
+    uint64_t totalRequests = 0;
+    uint64_t frames = 0;
+};
+
+// Software virtual texture backed by a page file (see PageFile::bake).
+//
+// Each frame a low resolution feedback pass writes the page every pixel wants
+// (mip << 24 | y << 12 | x). The result is copied back to the host and missing pages are
+// handed to a streaming thread, which reads them from disk. Loaded tiles are copied
+// into a fixed-size physical cache texture, evicting the least recently requested page,
+// and the indirection texture (one texel per page, per mip) is rewritten so every page
+// points at itself or its closest resident ancestor. The coarsest mip stays pinned, so
+// every lookup resolves. No sparse binding is needed.
+class VirtualTexture {
+public:
+    static constexpr uint32_t kFeedbackDivisor = 8;
+    static constexpr uint32_t kMaxUploadsPerFrame = 16;
+    static constexpr uint32_t kInvalidPage = 0xFFFFFFFF;
+
+    VirtualTexture(const vk::raii::Device& device,
+                   const vk::raii::PhysicalDevice& physicalDevice,
+                   const vk::raii::CommandPool& commandPool,
+                   const vk::raii::Queue& queue,
+                   const std::string& pageFilePath,
+                   vk::Extent2D renderExtent,
+                   vk::Format depthFormat,
+                   ObjectCache& cache,
+                   uint32_t cachePagesPerSide = 16);
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    const vk::raii::ImageView& getCacheView() const { return cacheView; }
+    vk::Sampler getCacheSampler() const { return cacheSampler; }
+    const vk::raii::ImageView& getIndirectionView() const { return indirectionView; }
+    vk::Sampler getIndirectionSampler() const { return indirectionSampler; }
+
+    const vk::raii::RenderPass& getFeedbackRenderPass() const { return feedbackRenderPass; }
+    const vk::raii::Framebuffer& getFeedbackFramebuffer() const { return feedbackFramebuffer; }
+    vk::Extent2D getFeedbackExtent() const { return feedbackExtent; }
+
+    // `forFeedback` selects the mip bias that compensates for the reduced feedback resolution
+    VirtualTextureParams getParams(bool forFeedback) const;
+    VirtualTextureStats getStats() const;
+
+    // Call once the previous frame's fence has signalled: turns its feedback into page requests
+    void processFeedback();
+    // Records copies for pages the streaming thread finished, plus the indirection refresh
+    void update(const vk::raii::CommandBuffer& commandBuffer);
+    // Records the feedback image -> host buffer copy; call right after the feedback pass
+    void recordFeedbackReadback(const vk::raii::CommandBuffer& commandBuffer);
+
+private:
+    struct Slot {
+        uint32_t page = kInvalidPage;
+        bool pinned = false;
+        std::list<uint32_t>::iterator lruIt;
+    };
+
+    struct StreamedPage {
+        uint32_t page;
+        std::vector<uint8_t> pixels;
+    };
+
+    PageFile pageFile;
+    PageFileHeader header;
+    uint32_t tileSize;
+    vk::DeviceSize tileBytes;
+    uint32_t cachePagesPerSide;
+
+    vk::raii::Image cacheImage = nullptr;
+    vk::raii::DeviceMemory cacheMemory = nullptr;
+    vk::raii::ImageView cacheView = nullptr;
+    vk::Sampler cacheSampler;          // owned by the ObjectCache
+
+    vk::raii::Image indirectionImage = nullptr;
+    vk::raii::DeviceMemory indirectionMemory = nullptr;
+    vk::raii::ImageView indirectionView = nullptr;
+    vk::Sampler indirectionSampler;    // owned by the ObjectCache
+
+    vk::raii::Buffer stagingBuffer = nullptr;
+    vk::raii::DeviceMemory stagingMemory = nullptr;
+    uint8_t* stagingMapped = nullptr;
+
+    vk::Extent2D feedbackExtent;
+    vk::raii::Image feedbackImage = nullptr;
+    vk::raii::DeviceMemory feedbackMemory = nullptr;
+    vk::raii::ImageView feedbackView = nullptr;
+    vk::raii::Image feedbackDepthImage = nullptr;
+    vk::raii::DeviceMemory feedbackDepthMemory = nullptr;
+    vk::raii::ImageView feedbackDepthView = nullptr;
+    vk::raii::RenderPass feedbackRenderPass = nullptr;
+    vk::raii::Framebuffer feedbackFramebuffer = nullptr;
+    vk::raii::Buffer readbackBuffer = nullptr;
+    vk::raii::DeviceMemory readbackMemory = nullptr;
+    const uint32_t* readbackMapped = nullptr;
+    bool feedbackPending = false;
+
+    // Residency. `lru` holds unpinned slot indices, most recently requested first.
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::list<uint32_t> lru;
+    std::unordered_map<uint32_t, uint32_t> residentPages;
+    std::unordered_set<uint32_t> pendingPages;
+    std::vector<vk::BufferImageCopy> stagedCopies;
+
+    // Host copy of the indirection texture, one RGBA8 texel (slot x, slot y, mip, 255) per page
+    std::vector<std::vector<uint32_t>> indirection;
+    bool indirectionDirty = true;
+
+    // Streaming thread
+    std::thread streamThread;
+    std::mutex streamMutex;
+    std::condition_variable streamCv;
+    std::deque<uint32_t> streamRequests;
+    std::vector<StreamedPage> streamedPages;
+    bool stopStreaming = false;
+
+    vk::DeviceSize allocatedBytes = 0;
+    uint32_t faultsLastFrame = 0;
+    uint64_t totalFaults = 0;
+    uint64_t totalRequests = 0;
+    uint64_t frames = 0;
+
+    static uint32_t packPage(uint32_t mip, uint32_t x, uint32_t y) { return (mip << 24) | (y << 12) | x; }
+    static uint32_t pageMip(uint32_t page) { return page >> 24; }
+    static uint32_t pageY(uint32_t page) { return (page >> 12) & 0xFFF; }
+    static uint32_t pageX(uint32_t page) { return page & 0xFFF; }
+
+    void createCache(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, ObjectCache& cache);
+    void createIndirection(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, ObjectCache& cache);
+    void createFeedbackResources(const vk::raii::Device& device, const vk::raii::PhysicalDevice& physicalDevice, vk::Format depthFormat);
+    void loadPinnedPages(const vk::raii::Device& device, const vk::raii::CommandPool& commandPool, const vk::raii::Queue& queue);
+
+    bool stagePage(uint32_t page, const uint8_t* pixels, uint32_t uploadIndex, bool pinned);
+    uint32_t acquireSlot();
+    void rebuildIndirection();
+    void recordUploads(const vk::raii::CommandBuffer& commandBuffer, vk::ImageLayout oldLayout);
+
+    void streamLoop(std::string path);
+};
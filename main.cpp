@@ -14,6 +14,25 @@
 // Model support
 #include "Model.h"
 
+// Frame capture / replay
+#include "FrameCapture.h"
+
+// Virtual texturing
+#include "VirtualTexture.h"
+
+// Meshlet clustering and culling
+#include "ClusterCuller.h"
+#include "Meshlet.h"
+
+// Hi-Z occlusion culling
+#include "OcclusionCuller.h"
+
+// Render pass, pipeline and transforms shared with TriangleBench
+#include "Scene.h"
+
+// Deduplicated samplers/layouts and per-frame descriptor arenas
+#include "ObjectCache.h"
+
 // Vulkan RAII and Standard Headers
 #if defined(__INTELLISENSE__) || !defined(USE_CPP20_MODULES)
     #include <vulkan/vulkan_raii.hpp>
@@ -35,12 +54,37 @@
 #include <vector>
 #include <array>
 
+struct AppOptions {
+    std::string capturePath;     // --capture <file>
+    uint32_t captureFrames = 600; // --capture-frames <n>, 0 = until the window closes
+    std::string replayPath;      // --replay <file>
+    uint32_t replayLoops = 1;    // --replay-loops <n>
+    std::string virtualTexturePath; // --vt <pagefile>
+    std::string bakeImagePath;   // --bake-vt <image>, writes <image>.vtpf and exits
+    bool meshlets = false;       // --meshlets, per-cluster GPU culling + indirect draws
+    bool occlusion = false;      // --occlusion, two-phase Hi-Z instance culling
+    bool dynamicRendering = false; // --dynamic-rendering, no render pass or framebuffer objects
+};
+
 class HelloTriangleApplication {
 public:
+    explicit HelloTriangleApplication(AppOptions options) : options(std::move(options)) {}
+
     void run() {
-        initWindow();
+        // Load the capture up front so a bad file or mismatched options fail before any Vulkan setup
+        std::unique_ptr<FrameReplayer> replayer;
+        if (!options.replayPath.empty()) {
+            replayer = std::make_unique<FrameReplayer>(options.replayPath);
+            checkCaptureConfig(replayer->getConfigFlags());
+        }
+
+        if (!headless()) initWindow();
         initVulkan();
-        mainLoop();
+        if (!replayer) {
+            mainLoop();
+        } else {
+            replayCapture(*replayer);
+        }
         cleanup();
     }
 
@@ -48,11 +92,17 @@ private:
     // --- 1. CONFIGURATION ---
     const uint32_t WIDTH = 800;
     const uint32_t HEIGHT = 600;
-    static constexpr int INSTANCE_COUNT = 10;
-
+    static constexpr int INSTANCE_COUNT = kSceneBatchSize;
+    // Captured framebuffer indices are swapchain image indices; headless replays map them all
+    // to one offscreen framebuffer, and no presentation engine hands out more images than this
+    static constexpr uint32_t kReplayFramebufferSlots = 16;
+    // Capture header flags for the options that change what drawFrame records
+    static constexpr uint32_t kCaptureMeshlets = 1u << 0;
+    static constexpr uint32_t kCaptureOcclusion = 1u << 1;
+
+    // VK_KHR_portability_subset is added in createLogicalDevice when the device exposes it (MoltenVK)
     const std::vector<const char*> deviceExtensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-        "VK_KHR_portability_subset"
+        VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
 
@@ -63,14 +113,10 @@ private:
         std::vector<vk::PresentModeKHR> presentModes;
     };
 
-    struct UniformBufferObject {
-        alignas(16) glm::mat4 models[INSTANCE_COUNT];
-        alignas(16) glm::mat4 view;
-        alignas(16) glm::mat4 proj;
-    };
+    using UniformBufferObject = SceneUniforms;
 
     // --- 3. CLASS MEMBERS ---
-    GLFWwindow* window;
+    GLFWwindow* window = nullptr;
     vk::raii::Context context;
     vk::raii::Instance instance = nullptr;
     vk::raii::SurfaceKHR surface = nullptr;
@@ -79,6 +125,7 @@ private:
     vk::raii::Device device = nullptr;
     vk::raii::Queue graphicsQueue = nullptr;
     vk::raii::Queue presentQueue = nullptr;
+    std::unique_ptr<ObjectCache> objectCache;  // declared after the device, so destroyed before it
 
     vk::raii::SwapchainKHR swapChain = nullptr;
     std::vector<vk::Image> swapChainImages;
@@ -87,7 +134,9 @@ private:
     std::vector<vk::raii::ImageView> swapChainImageViews;
 
     vk::raii::RenderPass renderPass = nullptr;
-    vk::raii::PipelineLayout pipelineLayout = nullptr;
+    vk::raii::RenderPass earlyRenderPass = nullptr;  // --occlusion splits the scene pass around the pyramid build
+    vk::raii::RenderPass lateRenderPass = nullptr;
+    vk::PipelineLayout pipelineLayout;  // owned by objectCache
     vk::raii::Pipeline graphicsPipeline = nullptr;
     std::vector<vk::raii::Framebuffer> swapChainFramebuffers;
 
@@ -98,9 +147,8 @@ private:
     vk::raii::Semaphore renderFinishedSemaphore = nullptr;
     vk::raii::Fence inFlightFence = nullptr;
 
-    vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
-    vk::raii::DescriptorPool descriptorPool = nullptr;
-    vk::raii::DescriptorSets descriptorSets = nullptr;
+    vk::DescriptorSetLayout descriptorSetLayout;  // owned by objectCache
+    vk::DescriptorSet persistentDescriptorSet;     // written once; its contents never change between frames
 
     vk::raii::Buffer uniformBuffer = nullptr;
     vk::raii::DeviceMemory uniformBufferMemory = nullptr;
@@ -114,14 +162,40 @@ private:
     std::unique_ptr<Texture> texture;
     std::unique_ptr<Model> model;
 
+    std::unique_ptr<VirtualTexture> virtualTexture;
+    vk::raii::Pipeline feedbackPipeline = nullptr;
+
+    std::unique_ptr<ClusterCuller> clusterCuller;
+    std::unique_ptr<OcclusionCuller> occlusionCuller;
+    bool drawIndirectCountSupported = false;
+    bool multiDrawIndirectSupported = false;
+    glm::vec3 cameraPosition{5.0f, 5.0f, 5.0f};
+    glm::mat4 cameraViewProj{1.0f};
+
     vk::SampleCountFlagBits msaaSamples = vk::SampleCountFlagBits::e4;
     vk::raii::Image colorImage = nullptr;
     vk::raii::DeviceMemory colorImageMemory = nullptr;
     vk::raii::ImageView colorImageView = nullptr;
+
+    // MSAA color/depth footprint; transient attachments land in lazily allocated memory when offered
+    vk::DeviceSize attachmentBytes = 0;
+    vk::DeviceSize lazyAttachmentBytes = 0;
+    bool colorImageLazy = false;
+    bool depthImageLazy = false;
     
     uint32_t graphicsFamilyIndex = 0;
     uint32_t presentFamilyIndex = 0;
 
+    AppOptions options;
+    CaptureResources captureResources;
+    std::unique_ptr<FrameCapture> capture;
+
+    // Offscreen resolve target so replays never touch the swapchain
+    vk::raii::Image replayImage = nullptr;
+    vk::raii::DeviceMemory replayImageMemory = nullptr;
+    vk::raii::ImageView replayImageView = nullptr;
+    vk::raii::Framebuffer replayFramebuffer = nullptr;
+
     // --- 4. INITIALIZATION FUNCTIONS ---
 
     void initWindow() {
@@ -131,40 +205,63 @@ private:
         window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
     }
 
+    // Replays render into an offscreen target, so they need no window, surface or swapchain
+    bool headless() const { return !options.replayPath.empty(); }
+
     void initVulkan() {
         createInstance();
-        createSurface();
+        if (!headless()) createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
-        createSwapChain();
-        createImageViews();
+        if (headless()) {
+            useOffscreenTarget();
+        } else {
+            createSwapChain();
+            createImageViews();
+        }
         createColorResources();
         createDepthResources();
-        createRenderPass();
+        if (!options.dynamicRendering) createRenderPass();
         createDescriptorSetLayout();
         createGraphicsPipeline();
-        createFramebuffers();
+        if (!options.dynamicRendering) createFramebuffers();
         createCommandPool();
         model = std::make_unique<Model>(device, physicalDevice, commandPool, graphicsQueue, "models/Cube/Cube.gltf");
-        texture = std::make_unique<Texture>(device, physicalDevice, commandPool, graphicsQueue, "textures/texture.jpg");
+        texture = std::make_unique<Texture>(device, physicalDevice, commandPool, graphicsQueue, "textures/texture.jpg", objectCache.get());
+        if (!options.virtualTexturePath.empty()) {
+            virtualTexture = std::make_unique<VirtualTexture>(device, physicalDevice, commandPool, graphicsQueue, options.virtualTexturePath, swapChainExtent,
+                depthFormat, *objectCache);
+            createFeedbackPipeline();
+        }
         createCommandBuffer();
         createSyncObjects();
         createUniformBuffer();
-        createDescriptorPool();
         createDescriptorSets();
+        if (options.meshlets) createClusterCuller();
+        if (options.occlusion) createOcclusionCuller();
+        if (!options.dynamicRendering) createCaptureResources();
+        reportAttachmentMemory();
     }
 
     void createInstance() {
         vk::ApplicationInfo appInfo("Hello Triangle", VK_MAKE_VERSION(1, 0, 0), "No Engine", VK_MAKE_VERSION(1, 0, 0), VK_API_VERSION_1_3);
 
         uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        const char** glfwExtensions = headless() ? nullptr : glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
         std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
-        extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
         extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
+        // Portability enumeration is only needed (and only present) on loaders that ship MoltenVK
+        vk::InstanceCreateFlags flags{};
+        for (const auto& ext : context.enumerateInstanceExtensionProperties()) {
+            if (std::string(ext.extensionName.data()) == VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME) {
+                extensions.push_back(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME);
+                flags |= vk::InstanceCreateFlagBits::eEnumeratePortabilityKHR;
+            }
+        }
+
         vk::InstanceCreateInfo createInfo(
-            vk::InstanceCreateFlagBits::eEnumeratePortabilityKHR, &appInfo, 0, nullptr,
+            flags, &appInfo, 0, nullptr,
             static_cast<uint32_t>(extensions.size()), extensions.data()
         );
 
@@ -182,6 +279,15 @@ private:
     void pickPhysicalDevice() {
         vk::raii::PhysicalDevices devices(instance);
         for (const auto& dev : devices) {
+            if (headless()) {
+                // Replays only need a graphics queue
+                auto families = dev.getQueueFamilyProperties();
+                if (std::any_of(families.begin(), families.end(), [](const auto& family) { return bool(family.queueFlags & vk::QueueFlagBits::eGraphics); })) {
+                    physicalDevice = dev;
+                    break;
+                }
+                continue;
+            }
             if (checkDeviceExtensionSupport(dev)) {
                 SwapChainSupportDetails swapChainSupport = querySwapChainSupport(dev);
                 if (!swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty()) {
@@ -204,11 +310,12 @@ private:
             if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics) {
                 graphicsFamilyIndex = i; graphicsFound = true;
             }
-            if (physicalDevice.getSurfaceSupportKHR(i, *surface)) {
+            if (!headless() && physicalDevice.getSurfaceSupportKHR(i, *surface)) {
                 presentFamilyIndex = i; presentFound = true;
             }
-            if (graphicsFound && presentFound) break;
+            if (graphicsFound && (presentFound || headless())) break;
         }
+        if (headless()) presentFamilyIndex = graphicsFamilyIndex;
 
         std::vector<vk::DeviceQueueCreateInfo> queueInfos;
         std::set<uint32_t> uniqueFamilies = {graphicsFamilyIndex, presentFamilyIndex};
@@ -217,12 +324,66 @@ private:
             queueInfos.push_back({{}, family, 1, &priority});
         }
 
+        // Indirect draw features used by the meshlet path, enabled whenever the device has them
         vk::PhysicalDeviceFeatures features{};
-        vk::DeviceCreateInfo createInfo({}, queueInfos, {}, deviceExtensions, &features);
+        features.multiDrawIndirect = physicalDevice.getFeatures().multiDrawIndirect;
+        multiDrawIndirectSupported = features.multiDrawIndirect;
+        // The meshlet and occlusion culls pick each draw's model matrix through the command's firstInstance
+        features.drawIndirectFirstInstance = physicalDevice.getFeatures().drawIndirectFirstInstance;
+        if ((options.meshlets || options.occlusion) && !features.drawIndirectFirstInstance) {
+            throw std::runtime_error("--meshlets and --occlusion need the drawIndirectFirstInstance feature!");
+        }
+
+        vk::PhysicalDeviceVulkan12Features features12{};
+        bool vulkan12 = physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_2;
+        if (vulkan12) {
+            auto supported = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+            features12.drawIndirectCount = supported.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+            drawIndirectCountSupported = features12.drawIndirectCount;
+        }
+
+        std::vector<const char*> extensions = headless() ? std::vector<const char*>{} : deviceExtensions;
+        std::set<std::string> availableExtensions;
+        for (const auto& ext : physicalDevice.enumerateDeviceExtensionProperties()) availableExtensions.insert(ext.extensionName.data());
+        if (availableExtensions.count("VK_KHR_portability_subset")) extensions.push_back("VK_KHR_portability_subset");
+
+        // --dynamic-rendering: core in 1.3, otherwise the KHR extensions on a 1.2 device (MoltenVK).
+        // vulkan.hpp's dispatcher falls back to the KHR entry points, so recording uses the core names.
+        vk::PhysicalDeviceVulkan13Features features13{};
+        vk::PhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+        vk::PhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+        void* renderingFeatures = nullptr;
+        if (options.dynamicRendering) {
+            if (physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_3) {
+                auto supported = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features>().get<vk::PhysicalDeviceVulkan13Features>();
+                if (!supported.dynamicRendering || !supported.synchronization2) {
+                    throw std::runtime_error("device lacks dynamicRendering or synchronization2!");
+                }
+                features13.dynamicRendering = VK_TRUE;
+                features13.synchronization2 = VK_TRUE;
+                renderingFeatures = &features13;
+            } else if (vulkan12 && availableExtensions.count(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+                       availableExtensions.count(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+                extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+                extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+                dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+                dynamicRenderingFeatures.pNext = &synchronization2Features;
+                synchronization2Features.synchronization2 = VK_TRUE;
+                renderingFeatures = &dynamicRenderingFeatures;
+            } else {
+                throw std::runtime_error("dynamic rendering needs Vulkan 1.3 or VK_KHR_dynamic_rendering + VK_KHR_synchronization2!");
+            }
+        }
+        features12.pNext = renderingFeatures;
+
+        vk::DeviceCreateInfo createInfo({}, queueInfos, {}, extensions, &features, vulkan12 ? static_cast<void*>(&features12) : renderingFeatures);
 
         device = vk::raii::Device(physicalDevice, createInfo);
         graphicsQueue = vk::raii::Queue(device, graphicsFamilyIndex, 0);
         presentQueue = vk::raii::Queue(device, presentFamilyIndex, 0);
+
+        // One frame in flight, so one frame arena
+        objectCache = std::make_unique<ObjectCache>(device, 1);
     }
 
     void createSwapChain() {
@@ -260,6 +421,12 @@ private:
         std::cout << "Swapchain created (" << swapChainExtent.width << "x" << swapChainExtent.height << ")" << std::endl;
     }
 
+    // Headless stand-in for createSwapChain: the window's size and preferred format, no images
+    void useOffscreenTarget() {
+        swapChainImageFormat = vk::Format::eB8G8R8A8Srgb;
+        swapChainExtent = vk::Extent2D(WIDTH, HEIGHT);
+    }
+
     void createImageViews() {
         swapChainImageViews.clear();
         for (const auto& image : swapChainImages) {
@@ -271,16 +438,18 @@ private:
     void createColorResources() {
         vk::Format colorFormat = swapChainImageFormat;
 
+        // The occlusion split stores the early pass's color for the late pass to load, which
+        // would commit all of a lazy allocation anyway, so it is only transient without it
+        bool transient = !options.occlusion;
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eColorAttachment;
+        if (transient) usage |= vk::ImageUsageFlagBits::eTransientAttachment;
         vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, colorFormat, 
             {swapChainExtent.width, swapChainExtent.height, 1}, 1, 1, 
-            msaaSamples, vk::ImageTiling::eOptimal, 
-            vk::ImageUsageFlagBits::eTransientAttachment | vk::ImageUsageFlagBits::eColorAttachment);
+            msaaSamples, vk::ImageTiling::eOptimal, usage);
 
         colorImage = vk::raii::Image(device, imageInfo);
 
-        vk::MemoryRequirements memReq = colorImage.getMemoryRequirements();
-        vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
-        colorImageMemory = vk::raii::DeviceMemory(device, allocInfo);
+        colorImageMemory = allocateAttachmentMemory(colorImage.getMemoryRequirements(), transient, colorImageLazy);
         colorImage.bindMemory(*colorImageMemory, 0);
 
         vk::ImageViewCreateInfo viewInfo({}, *colorImage, vk::ImageViewType::e2D, colorFormat, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
@@ -288,36 +457,13 @@ private:
     }
 
     void createRenderPass() {
-        // 1. Multisampled Color
-        vk::AttachmentDescription colorAttachment({}, swapChainImageFormat, msaaSamples, 
-            vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore, 
-            vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, 
-            vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal);
-        // 2. Multisampled Depth
-        vk::AttachmentDescription depthAttachment({}, depthFormat, msaaSamples, 
-            vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eDontCare, 
-            vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, 
-            vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        // 3. Resolve Attachment
-        vk::AttachmentDescription colorAttachmentResolve({}, swapChainImageFormat, vk::SampleCountFlagBits::e1, 
-            vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eStore, 
-            vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare, 
-            vk::ImageLayout::eUndefined, vk::ImageLayout::ePresentSrcKHR);
-
-        vk::AttachmentReference colorRef(0, vk::ImageLayout::eColorAttachmentOptimal);
-        vk::AttachmentReference depthRef(1, vk::ImageLayout::eDepthStencilAttachmentOptimal);
-        vk::AttachmentReference resolveRef(2, vk::ImageLayout::eColorAttachmentOptimal);
-
-        vk::SubpassDescription subpass({}, vk::PipelineBindPoint::eGraphics, 0, nullptr, 1, &colorRef, &resolveRef, &depthRef);
-        std::array<vk::AttachmentDescription, 3> attachments = {colorAttachment, depthAttachment, colorAttachmentResolve};
-
-        vk::SubpassDependency dependency(VK_SUBPASS_EXTERNAL, 0, 
-            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests, 
-            vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests, 
-            {}, vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
-
-        vk::RenderPassCreateInfo renderPassInfo({}, static_cast<uint32_t>(attachments.size()), attachments.data(), 1, &subpass, 1, &dependency);
-        renderPass = vk::raii::RenderPass(device, renderPassInfo);
+        // ePresentSrcKHR needs VK_KHR_swapchain, which headless devices don't enable
+        vk::ImageLayout resolveLayout = headless() ? vk::ImageLayout::eColorAttachmentOptimal : vk::ImageLayout::ePresentSrcKHR;
+        renderPass = createSceneRenderPass(device, swapChainImageFormat, depthFormat, msaaSamples, resolveLayout);
+        if (options.occlusion) {
+            earlyRenderPass = createSceneRenderPass(device, swapChainImageFormat, depthFormat, msaaSamples, resolveLayout, ScenePass::Early);
+            lateRenderPass = createSceneRenderPass(device, swapChainImageFormat, depthFormat, msaaSamples, resolveLayout, ScenePass::Late);
+        }
     }
 
     void createDescriptorSetLayout() {
@@ -334,83 +480,84 @@ private:
         samplerLayoutBinding.pImmutableSamplers = nullptr;
         samplerLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-        std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
-        vk::DescriptorSetLayoutCreateInfo layoutInfo({}, static_cast<uint32_t>(bindings.size()), bindings.data());
-        
-        descriptorSetLayout = vk::raii::DescriptorSetLayout(device, layoutInfo);
-    }
-
-    void createDescriptorPool() {
-        std::array<vk::DescriptorPoolSize, 2> poolSizes{};
-        poolSizes[0].type = vk::DescriptorType::eUniformBuffer;
-        poolSizes[0].descriptorCount = 1;
-        poolSizes[1].type = vk::DescriptorType::eCombinedImageSampler;
-        poolSizes[1].descriptorCount = 1;
+        // Virtual texture indirection + physical page cache (aliases the plain texture when VT is off)
+        vk::DescriptorSetLayoutBinding indirectionLayoutBinding(2, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
+        vk::DescriptorSetLayoutBinding cacheLayoutBinding(3, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment);
 
-        vk::DescriptorPoolCreateInfo poolInfo({}, 1, static_cast<uint32_t>(poolSizes.size()), poolSizes.data());
-        descriptorPool = vk::raii::DescriptorPool(device, poolInfo);
+        std::array<vk::DescriptorSetLayoutBinding, 4> bindings = {uboLayoutBinding, samplerLayoutBinding, indirectionLayoutBinding, cacheLayoutBinding};
+        descriptorSetLayout = objectCache->getDescriptorSetLayout(bindings);
     }
 
     void createDescriptorSets() {
-        vk::DescriptorSetAllocateInfo allocInfo(*descriptorPool, *descriptorSetLayout);
-        descriptorSets = vk::raii::DescriptorSets(device, allocInfo);
+        persistentDescriptorSet = objectCache->allocatePersistentSet(descriptorSetLayout);
+        writeSceneDescriptorSet(persistentDescriptorSet);
+    }
 
+    void writeSceneDescriptorSet(vk::DescriptorSet set) {
         vk::DescriptorBufferInfo bufferInfo(*uniformBuffer, 0, sizeof(UniformBufferObject));
-        vk::DescriptorImageInfo imageInfo(*texture->getSampler(), *texture->getView(), vk::ImageLayout::eShaderReadOnlyOptimal);
-        std::array<vk::WriteDescriptorSet, 2> descriptorWrites{};
+        vk::DescriptorImageInfo imageInfo(texture->getSampler(), *texture->getView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+        vk::DescriptorImageInfo indirectionInfo = imageInfo;
+        vk::DescriptorImageInfo cacheInfo = imageInfo;
+        if (virtualTexture) {
+            indirectionInfo = vk::DescriptorImageInfo(virtualTexture->getIndirectionSampler(), *virtualTexture->getIndirectionView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+            cacheInfo = vk::DescriptorImageInfo(virtualTexture->getCacheSampler(), *virtualTexture->getCacheView(), vk::ImageLayout::eShaderReadOnlyOptimal);
+        }
+        std::array<vk::WriteDescriptorSet, 4> descriptorWrites{};
 
-        descriptorWrites[0].dstSet = *descriptorSets[0];
+        descriptorWrites[0].dstSet = set;
         descriptorWrites[0].dstBinding = 0;
         descriptorWrites[0].descriptorType = vk::DescriptorType::eUniformBuffer;
         descriptorWrites[0].descriptorCount = 1;
         descriptorWrites[0].pBufferInfo = &bufferInfo;
 
-        descriptorWrites[1].dstSet = *descriptorSets[0];
+        descriptorWrites[1].dstSet = set;
         descriptorWrites[1].dstBinding = 1;
         descriptorWrites[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
         descriptorWrites[1].descriptorCount = 1;
         descriptorWrites[1].pImageInfo = &imageInfo;
 
+        descriptorWrites[2].dstSet = set;
+        descriptorWrites[2].dstBinding = 2;
+        descriptorWrites[2].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pImageInfo = &indirectionInfo;
+
+        descriptorWrites[3].dstSet = set;
+        descriptorWrites[3].dstBinding = 3;
+        descriptorWrites[3].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+        descriptorWrites[3].descriptorCount = 1;
+        descriptorWrites[3].pImageInfo = &cacheInfo;
+
         device.updateDescriptorSets(descriptorWrites, nullptr);
     }
 
     void createGraphicsPipeline() {
-        auto vertCode = readFile("shaders/vert.spv");
-        auto fragCode = readFile("shaders/frag.spv");
-
-        vk::raii::ShaderModule vertModule = createShaderModule(vertCode);
-        vk::raii::ShaderModule fragModule = createShaderModule(fragCode);
-
-        vk::PipelineShaderStageCreateInfo shaderStages[] = {
-            {{}, vk::ShaderStageFlagBits::eVertex, *vertModule, "main"},
-            {{}, vk::ShaderStageFlagBits::eFragment, *fragModule, "main"}
-        };
+        // The push constant range carries VirtualTextureParams; unused by the plain fragment shader
+        vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eFragment, 0, sizeof(VirtualTextureParams));
+        pipelineLayout = objectCache->getPipelineLayout(descriptorSetLayout, pushConstantRange);
+
+        const char* fragPath = options.virtualTexturePath.empty() ? "shaders/frag.spv" : "shaders/vt_shade.spv";
+        // The cluster culler's cone test rejects exactly what back-face culling would, so the two go together
+        vk::CullModeFlags cullMode = options.meshlets ? vk::CullModeFlagBits::eBack : vk::CullModeFlagBits::eNone;
+        if (options.dynamicRendering) {
+            vk::PipelineRenderingCreateInfo renderingInfo(0, 1, &swapChainImageFormat, depthFormat,
+                hasStencilComponent(depthFormat) ? depthFormat : vk::Format::eUndefined);
+            graphicsPipeline = createScenePipeline(fragPath, nullptr, swapChainExtent, msaaSamples, cullMode, &renderingInfo);
+        } else {
+            graphicsPipeline = createScenePipeline(fragPath, *renderPass, swapChainExtent, msaaSamples, cullMode);
+        }
+    }
 
-        auto bindingDescription = Vertex::getBindingDescription();
-        auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-        vk::PipelineDepthStencilStateCreateInfo depthStencil({}, VK_TRUE, VK_TRUE, vk::CompareOp::eLess, VK_FALSE, VK_FALSE);
-
-        vk::PipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-        vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-        vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, vk::PrimitiveTopology::eTriangleList, VK_FALSE);
-        vk::Viewport viewport(0.0f, 0.0f, (float)swapChainExtent.width, (float)swapChainExtent.height, 0.0f, 1.0f);
-        vk::Rect2D scissor({0, 0}, swapChainExtent);
-        vk::PipelineViewportStateCreateInfo viewportState({}, 1, &viewport, 1, &scissor);
-        vk::PipelineRasterizationStateCreateInfo rasterizer({}, VK_FALSE, VK_FALSE, vk::PolygonMode::eFill, vk::CullModeFlagBits::eNone, vk::FrontFace::eCounterClockwise, VK_FALSE, 0.0f, 0.0f, 0.0f, 1.0f);
-        vk::PipelineMultisampleStateCreateInfo multisampling({}, msaaSamples, VK_FALSE);
-        vk::PipelineColorBlendAttachmentState colorBlendAttachment(VK_FALSE, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
-        vk::PipelineColorBlendStateCreateInfo colorBlending({}, VK_FALSE, vk::LogicOp::eCopy, 1, &colorBlendAttachment);
-        
-        vk::PipelineLayoutCreateInfo layoutInfo({}, 1, &*descriptorSetLayout, 0, nullptr);
-        pipelineLayout = vk::raii::PipelineLayout(device, layoutInfo);
+    void createFeedbackPipeline() {
+        feedbackPipeline = createScenePipeline("shaders/vt_feedback.spv", *virtualTexture->getFeedbackRenderPass(),
+            virtualTexture->getFeedbackExtent(), vk::SampleCountFlagBits::e1);
+    }
 
-        vk::GraphicsPipelineCreateInfo pipelineInfo({}, 2, shaderStages, &vertexInputInfo, &inputAssembly, nullptr, &viewportState, &rasterizer, &multisampling, &depthStencil, &colorBlending, nullptr, *pipelineLayout, *renderPass, 0);
-        graphicsPipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+    vk::raii::Pipeline createScenePipeline(const std::string& fragPath, vk::RenderPass targetPass, vk::Extent2D extent, vk::SampleCountFlagBits samples,
+                                           vk::CullModeFlags cullMode = vk::CullModeFlagBits::eNone,
+                                           const vk::PipelineRenderingCreateInfo* renderingInfo = nullptr) {
+        return ::createScenePipeline(device, readShaderFile("shaders/vert.spv"), readShaderFile(fragPath), pipelineLayout, targetPass, extent, samples,
+            cullMode, renderingInfo);
     }
 
     void createFramebuffers() {
@@ -446,72 +593,438 @@ private:
         (void)device.waitForFences(*inFlightFence, VK_TRUE, UINT64_MAX);
         device.resetFences(*inFlightFence);
 
+        // The previous frame has retired, so its feedback and culling results are complete
+        if (virtualTexture) virtualTexture->processFeedback();
+        if (clusterCuller) clusterCuller->readStats();
+        if (occlusionCuller) occlusionCuller->readStats();
+
         auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, *imageAvailableSemaphore);
         const auto& commandBuffer = commandBuffers[0];
+        if (capture) capture->beginFrame();
         updateUniformBuffer();
         
         commandBuffer.reset();
         commandBuffer.begin(vk::CommandBufferBeginInfo{});
 
+        if (clusterCuller) clusterCuller->recordCull(commandBuffer, cameraViewProj, cameraPosition, capture.get());
+        if (occlusionCuller) occlusionCuller->recordCull(commandBuffer, OcclusionPhase::Early, cameraViewProj, capture.get());
+
+        if (virtualTexture) {
+            virtualTexture->update(commandBuffer);
+
+            std::array<vk::ClearValue, 2> feedbackClears{};
+            feedbackClears[0].color = vk::ClearColorValue(std::array<uint32_t, 4>{VirtualTexture::kInvalidPage, 0, 0, 0});
+            feedbackClears[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+
+            beginRenderPass(commandBuffer, *virtualTexture->getFeedbackRenderPass(), *virtualTexture->getFeedbackFramebuffer(),
+                virtualTexture->getFeedbackExtent(), feedbackClears.data(), static_cast<uint32_t>(feedbackClears.size()));
+            drawModel(commandBuffer, *feedbackPipeline, true);
+            endRenderPass(commandBuffer);
+            virtualTexture->recordFeedbackReadback(commandBuffer);
+        }
+
         std::array<vk::ClearValue, 3> clearValues{};
         clearValues[0].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
         clearValues[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
         clearValues[2].color = vk::ClearColorValue(std::array<float, 4>{0.0f, 0.0f, 0.0f, 1.0f});
 
-        vk::RenderPassBeginInfo renderPassInfo(*renderPass, *swapChainFramebuffers[imageIndex], vk::Rect2D({0, 0}, swapChainExtent), static_cast<uint32_t>(clearValues.size()), clearValues.data());
+        if (occlusionCuller) {
+            // Early pass draws what passed against last frame's pyramid; its depth rebuilds the
+            // pyramid, and the late pass adds whatever the re-test finds visible
+            beginScene(commandBuffer, imageIndex, ScenePass::Early, clearValues);
+            drawModel(commandBuffer, *graphicsPipeline, false, OcclusionPhase::Early);
+            endScene(commandBuffer, imageIndex, ScenePass::Early);
+
+            occlusionCuller->recordPyramidBuild(commandBuffer, capture.get());
+            occlusionCuller->recordCull(commandBuffer, OcclusionPhase::Late, cameraViewProj, capture.get());
+
+            beginScene(commandBuffer, imageIndex, ScenePass::Late, clearValues);
+            drawModel(commandBuffer, *graphicsPipeline, false, OcclusionPhase::Late);
+            endScene(commandBuffer, imageIndex, ScenePass::Late);
+        } else {
+            beginScene(commandBuffer, imageIndex, ScenePass::Full, clearValues);
+            drawModel(commandBuffer, *graphicsPipeline, false);
+            endScene(commandBuffer, imageIndex, ScenePass::Full);
+        }
+        commandBuffer.end();
+
+        if (capture) capture->endFrame();
+
+        if (options.dynamicRendering) {
+            vk::SemaphoreSubmitInfo waitInfo(*imageAvailableSemaphore, 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+            vk::CommandBufferSubmitInfo commandBufferInfo(*commandBuffer);
+            vk::SemaphoreSubmitInfo signalInfo(*renderFinishedSemaphore, 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+            vk::SubmitInfo2 submitInfo({}, waitInfo, commandBufferInfo, signalInfo);
+            graphicsQueue.submit2(submitInfo, *inFlightFence);
+        } else {
+            vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
+            vk::SubmitInfo submitInfo(*imageAvailableSemaphore, waitStages, *commandBuffer, *renderFinishedSemaphore);
+            graphicsQueue.submit(submitInfo, *inFlightFence);
+        }
+
+        vk::PresentInfoKHR presentInfo(*renderFinishedSemaphore, *swapChain, imageIndex);
+        (void)presentQueue.presentKHR(presentInfo);
+    }
+
+    // Begins one scene pass, through the render pass objects or through dynamic rendering
+    void beginScene(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex, ScenePass pass,
+                    const std::array<vk::ClearValue, 3>& clearValues) {
+        if (options.dynamicRendering) {
+            beginSceneRendering(commandBuffer, imageIndex, pass, clearValues);
+            return;
+        }
+        vk::RenderPass target = pass == ScenePass::Early ? *earlyRenderPass : pass == ScenePass::Late ? *lateRenderPass : *renderPass;
+        beginRenderPass(commandBuffer, target, *swapChainFramebuffers[imageIndex], swapChainExtent, clearValues.data(), static_cast<uint32_t>(clearValues.size()));
+    }
+
+    void endScene(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex, ScenePass pass) {
+        if (options.dynamicRendering) {
+            endSceneRendering(commandBuffer, imageIndex, pass);
+            return;
+        }
+        endRenderPass(commandBuffer);
+    }
 
+    // Dynamic rendering counterpart of createSceneRenderPass: same load/store ops per pass, with the
+    // layout transitions and dependencies the render pass implied recorded as synchronization2 barriers
+    void beginSceneRendering(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex, ScenePass pass,
+                             const std::array<vk::ClearValue, 3>& clearValues) {
+        bool early = pass == ScenePass::Early;
+        bool late = pass == ScenePass::Late;
+        constexpr vk::PipelineStageFlags2 colorStage = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+        constexpr vk::PipelineStageFlags2 depthStages = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests;
+        constexpr vk::AccessFlags2 depthAccess = vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite;
+        vk::ImageSubresourceRange colorRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+        std::vector<vk::ImageMemoryBarrier2> barriers;
+        if (!early) {
+            // Swapchain image receives the resolve; the acquire semaphore waits at colorStage
+            barriers.emplace_back(colorStage, vk::AccessFlagBits2::eNone, colorStage, vk::AccessFlagBits2::eColorAttachmentWrite,
+                vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                swapChainImages[imageIndex], colorRange);
+        }
+        if (late) {
+            // Early color is loaded again; depth comes back from the pyramid build's reads
+            barriers.emplace_back(colorStage, vk::AccessFlagBits2::eColorAttachmentWrite, colorStage,
+                vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
+                vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::eColorAttachmentOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                *colorImage, colorRange);
+            barriers.emplace_back(vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eNone, depthStages, depthAccess,
+                vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::ImageLayout::eDepthStencilAttachmentOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                *depthImage, depthSubresourceRange());
+        } else {
+            // Last frame's contents are discarded
+            barriers.emplace_back(colorStage, vk::AccessFlagBits2::eNone, colorStage, vk::AccessFlagBits2::eColorAttachmentWrite,
+                vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                *colorImage, colorRange);
+            barriers.emplace_back(depthStages, vk::AccessFlagBits2::eNone, depthStages, depthAccess,
+                vk::ImageLayout::eUndefined, vk::ImageLayout::eDepthStencilAttachmentOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                *depthImage, depthSubresourceRange());
+        }
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo({}, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data()));
+
+        // MSAA color is only stored for the late pass to load; otherwise it resolves straight to the swapchain
+        vk::RenderingAttachmentInfo colorAttachment(*colorImageView, vk::ImageLayout::eColorAttachmentOptimal,
+            early ? vk::ResolveModeFlagBits::eNone : vk::ResolveModeFlagBits::eAverage,
+            early ? vk::ImageView{} : *swapChainImageViews[imageIndex], vk::ImageLayout::eColorAttachmentOptimal,
+            late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+            early ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare, clearValues[0]);
+        vk::RenderingAttachmentInfo depthAttachment(*depthImageView, vk::ImageLayout::eDepthStencilAttachmentOptimal,
+            vk::ResolveModeFlagBits::eNone, {}, vk::ImageLayout::eUndefined,
+            late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear,
+            early ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare, clearValues[1]);
+
+        vk::RenderingInfo renderingInfo({}, vk::Rect2D({0, 0}, swapChainExtent), 1, 0, 1, &colorAttachment, &depthAttachment,
+            hasStencilComponent(depthFormat) ? &depthAttachment : nullptr);
+        commandBuffer.beginRendering(renderingInfo);
+    }
+
+    void endSceneRendering(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex, ScenePass pass) {
+        commandBuffer.endRendering();
+
+        vk::ImageMemoryBarrier2 barrier;
+        if (pass == ScenePass::Early) {
+            // Depth writes become visible to the pyramid build
+            barrier = vk::ImageMemoryBarrier2(vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+                vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+                vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::ImageLayout::eDepthStencilReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                *depthImage, depthSubresourceRange());
+        } else {
+            // Present waits on the semaphore signalled after colorStage, so no destination scope is needed
+            barrier = vk::ImageMemoryBarrier2(vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite,
+                vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                swapChainImages[imageIndex], vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+        }
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo({}, 0, nullptr, 0, nullptr, 1, &barrier));
+    }
+
+    // Recording helpers; each mirrors what it records into the active capture
+    void beginRenderPass(const vk::raii::CommandBuffer& commandBuffer, vk::RenderPass pass, vk::Framebuffer framebuffer,
+                         vk::Extent2D extent, const vk::ClearValue* clearValues, uint32_t clearValueCount) {
+        vk::RenderPassBeginInfo renderPassInfo(pass, framebuffer, vk::Rect2D({0, 0}, extent), clearValueCount, clearValues);
         commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
+        if (capture) capture->beginRenderPass(pass, framebuffer, extent, clearValues, clearValueCount);
+    }
+
+    void endRenderPass(const vk::raii::CommandBuffer& commandBuffer) {
+        commandBuffer.endRenderPass();
+        if (capture) capture->endRenderPass();
+    }
+
+    void drawModel(const vk::raii::CommandBuffer& commandBuffer, vk::Pipeline pipeline, bool feedback,
+                   OcclusionPhase occlusionPhase = OcclusionPhase::Early) {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
         vk::Buffer vertexBuffers[] = {*model->getVertexBuffer()};
         vk::DeviceSize offsets[] = {0};
+        vk::Buffer indexBuffer = clusterCuller ? *clusterCuller->getIndexBuffer() : *model->getIndexBuffer();
         
         commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
-        commandBuffer.bindIndexBuffer(*model->getIndexBuffer(), 0, vk::IndexType::eUint32);
+        commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
 
-        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, *descriptorSets[0], nullptr);
-        commandBuffer.drawIndexed(model->getIndexCount(), INSTANCE_COUNT, 0, 0, 0);
-        commandBuffer.endRenderPass();
-        commandBuffer.end();
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, persistentDescriptorSet, nullptr);
+
+        VirtualTextureParams vtParams{};
+        if (virtualTexture) {
+            vtParams = virtualTexture->getParams(feedback);
+            commandBuffer.pushConstants<VirtualTextureParams>(pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, vtParams);
+        }
 
-        vk::PipelineStageFlags waitStages[] = {vk::PipelineStageFlagBits::eColorAttachmentOutput};
-        vk::SubmitInfo submitInfo(*imageAvailableSemaphore, waitStages, *commandBuffer, *renderFinishedSemaphore);
-        graphicsQueue.submit(submitInfo, *inFlightFence);
+        if (capture) {
+            capture->bindPipeline(pipeline);
+            capture->bindVertexBuffer(0, vertexBuffers[0], offsets[0]);
+            capture->bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+            capture->bindDescriptorSet(pipelineLayout, 0, persistentDescriptorSet);
+            if (virtualTexture) capture->pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eFragment, 0, &vtParams, sizeof(vtParams));
+        }
 
-        vk::PresentInfoKHR presentInfo(*renderFinishedSemaphore, *swapChain, imageIndex);
-        (void)presentQueue.presentKHR(presentInfo);
+        if (clusterCuller) {
+            clusterCuller->recordDraw(commandBuffer, capture.get());
+        } else if (occlusionCuller && !feedback) {
+            occlusionCuller->recordDraw(commandBuffer, occlusionPhase, capture.get());
+        } else {
+            commandBuffer.drawIndexed(model->getIndexCount(), INSTANCE_COUNT, 0, 0, 0);
+            if (capture) capture->drawIndexed(model->getIndexCount(), INSTANCE_COUNT, 0, 0, 0);
+        }
     }
 
     void mainLoop() {
+        auto lastReport = std::chrono::steady_clock::now();
+        bool resourcesReported = false;
         while (!glfwWindowShouldClose(window)) {
             glfwPollEvents();
             drawFrame();
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReport >= std::chrono::seconds(1)) {
+                if (virtualTexture) reportVirtualTextureStats();
+                if (clusterCuller) reportClusterStats();
+                if (occlusionCuller) reportOcclusionStats();
+                if (!resourcesReported) {
+                    // Lazy memory is committed on first use, so the real saving shows after some frames
+                    reportAttachmentMemory();
+                    reportObjectCacheStats();
+                    resourcesReported = true;
+                }
+                lastReport = now;
+            }
         }
         device.waitIdle();
     }
 
-    void cleanup() {
-        glfwDestroyWindow(window);
-        glfwTerminate();
+    void reportVirtualTextureStats() {
+        VirtualTextureStats stats = virtualTexture->getStats();
+        constexpr double MiB = 1024.0 * 1024.0;
+        double faultRate = stats.totalRequests ? 100.0 * stats.totalFaults / stats.totalRequests : 0.0;
+        double faultsPerFrame = stats.frames ? double(stats.totalFaults) / stats.frames : 0.0;
+
+        std::cout << "VT: " << stats.residentPages << "/" << stats.cachePages << " pages resident ("
+                  << stats.residentBytes / MiB << " MiB, " << stats.allocatedBytes / MiB << " MiB allocated vs "
+                  << stats.fullChainBytes / MiB << " MiB fully resident), "
+                  << stats.faultsLastFrame << " faults last frame, " << faultsPerFrame << " avg/frame, "
+                  << faultRate << "% of requests faulted, " << stats.pendingPages << " pending" << std::endl;
     }
 
-    // --- 6. HELPERS ---
+    void reportAttachmentMemory() {
+        constexpr double MiB = 1024.0 * 1024.0;
+        vk::DeviceSize committed = 0;
+        if (colorImageLazy) committed += colorImageMemory.getCommitment();
+        if (depthImageLazy) committed += depthImageMemory.getCommitment();
+
+        std::cout << "Attachments: " << attachmentBytes / MiB << " MiB MSAA color/depth, " << lazyAttachmentBytes / MiB
+                  << " MiB lazily allocated, " << committed / MiB << " MiB committed ("
+                  << (lazyAttachmentBytes - committed) / MiB << " MiB saved)";
+        if (options.dynamicRendering) {
+            std::cout << "; dynamic rendering, no render pass or " << swapChainImages.size() << " framebuffers";
+        }
+        std::cout << std::endl;
+    }
+
+    void reportObjectCacheStats() {
+        ObjectCacheStats stats = objectCache->getStats();
+        auto hitRate = [](uint64_t hits, uint64_t requests) { return requests ? 100.0 * hits / requests : 0.0; };
+
+        std::cout << "Object cache: " << stats.liveSamplers << " samplers (" << hitRate(stats.samplerHits, stats.samplerRequests)
+                  << "% hits), " << stats.liveSetLayouts << " set layouts (" << hitRate(stats.setLayoutHits, stats.setLayoutRequests)
+                  << "% hits), " << stats.livePipelineLayouts << " pipeline layouts ("
+                  << hitRate(stats.pipelineLayoutHits, stats.pipelineLayoutRequests) << "% hits); "
+                  << stats.descriptorSetsAllocated << " descriptor sets from " << stats.descriptorPools << " pools, "
+                  << stats.arenaResets << " arena resets" << std::endl;
+    }
+
+    void reportClusterStats() {
+        const ClusterCullStats& stats = clusterCuller->getStats();
+        uint64_t rejected = stats.frustumCulledTriangles + stats.coneCulledTriangles;
+        double rejectedPercent = stats.totalTriangles ? 100.0 * rejected / stats.totalTriangles : 0.0;
+
+        std::cout << "Clusters: " << stats.visibleClusters << "/" << stats.totalClusters << " visible, "
+                  << rejected << "/" << stats.totalTriangles << " triangles rejected (" << rejectedPercent << "%: "
+                  << stats.frustumCulledTriangles << " frustum, " << stats.coneCulledTriangles << " cone)" << std::endl;
+    }
+
+    void createClusterCuller() {
+        std::vector<glm::vec3> positions;
+        positions.reserve(model->getVertices().size());
+        for (const Vertex& vertex : model->getVertices()) positions.push_back(vertex.pos);
+
+        MeshletMesh mesh = buildMeshlets(positions, model->getIndices());
+        // createGraphicsPipeline culls back faces in meshlet mode, so whole back-facing clusters can go too
+        clusterCuller = std::make_unique<ClusterCuller>(device, physicalDevice, commandPool, graphicsQueue, mesh, INSTANCE_COUNT,
+            *uniformBuffer, sizeof(UniformBufferObject), drawIndirectCountSupported, multiDrawIndirectSupported, true, *objectCache);
+
+        std::cout << "Built " << mesh.meshlets.size() << " meshlets from " << mesh.flattenedIndices.size() / 3 << " triangles" << std::endl;
+    }
+
+    void reportOcclusionStats() {
+        const OcclusionCullStats& stats = occlusionCuller->getStats();
+        uint32_t culled = stats.frustumCulled + stats.occluded;
+        double averageMs = stats.pyramidBuilds ? stats.pyramidBuildTotalMs / stats.pyramidBuilds : 0.0;
+
+        std::cout << "Occlusion: " << culled << "/" << stats.instances << " instances culled ("
+                  << stats.frustumCulled << " frustum, " << stats.occluded << " occluded), "
+                  << stats.earlyDrawn << " drawn early, " << stats.lateDrawn << " newly visible; Hi-Z "
+                  << stats.pyramidWidth << "x" << stats.pyramidHeight << " x" << stats.pyramidLevels << " levels built in "
+                  << stats.pyramidBuildMs << " ms (" << averageMs << " ms avg)" << std::endl;
+    }
+
+    void createOcclusionCuller() {
+        const auto& vertices = model->getVertices();
+        if (vertices.empty()) throw std::runtime_error("occlusion culling needs a non-empty model!");
+
+        glm::vec3 minP = vertices[0].pos, maxP = vertices[0].pos;
+        for (const Vertex& vertex : vertices) {
+            minP = glm::min(minP, vertex.pos);
+            maxP = glm::max(maxP, vertex.pos);
+        }
+        glm::vec3 center = (minP + maxP) * 0.5f;
+        float radius = 0.0f;
+        for (const Vertex& vertex : vertices) radius = std::max(radius, glm::length(vertex.pos - center));
+
+        // The pyramid build is timed when the graphics queue supports timestamps
+        float timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+        uint32_t timestampValidBits = physicalDevice.getQueueFamilyProperties()[graphicsFamilyIndex].timestampValidBits;
+
+        occlusionCuller = std::make_unique<OcclusionCuller>(device, physicalDevice, commandPool, graphicsQueue, *depthImageView, swapChainExtent,
+            INSTANCE_COUNT, glm::vec4(center, radius), model->getIndexCount(), *uniformBuffer, sizeof(UniformBufferObject),
+            drawIndirectCountSupported, multiDrawIndirectSupported, timestampPeriod, timestampValidBits, *objectCache);
+    }
+
+    void createCaptureResources() {
+        captureResources.renderPasses = {*renderPass};
+        if (occlusionCuller) {
+            captureResources.renderPasses.push_back(*earlyRenderPass);
+            captureResources.renderPasses.push_back(*lateRenderPass);
+        }
+        captureResources.pipelines = {*graphicsPipeline};
+        if (virtualTexture) {
+            captureResources.renderPasses.push_back(*virtualTexture->getFeedbackRenderPass());
+            captureResources.pipelines.push_back(*feedbackPipeline);
+        }
+        captureResources.pipelineLayouts = {pipelineLayout};
+        captureResources.buffers = {*model->getVertexBuffer(), *model->getIndexBuffer(), *uniformBuffer};
+        captureResources.mappedBuffers = {nullptr, nullptr, uniformBufferMapped};
+        captureResources.descriptorSets = {persistentDescriptorSet};
+        if (clusterCuller) clusterCuller->registerCaptureResources(captureResources);
+        if (occlusionCuller) occlusionCuller->registerCaptureResources(captureResources);
+
+        if (options.replayPath.empty()) {
+            for (const auto& framebuffer : swapChainFramebuffers) captureResources.framebuffers.push_back(*framebuffer);
+        } else {
+            // Every captured framebuffer index resolves into the same offscreen image
+            createReplayTarget();
+            captureResources.framebuffers.assign(kReplayFramebufferSlots, *replayFramebuffer);
+        }
+        if (virtualTexture) captureResources.framebuffers.push_back(*virtualTexture->getFeedbackFramebuffer());
+
+        if (!options.capturePath.empty()) {
+            capture = std::make_unique<FrameCapture>(options.capturePath, captureResources, captureConfigFlags(), options.captureFrames);
+            std::cout << "Capturing frames to " << options.capturePath << std::endl;
+        }
+    }
 
-    static std::vector<char> readFile(const std::string& filename) {
-        std::ifstream file(filename, std::ios::ate | std::ios::binary);
-        if (!file.is_open()) throw std::runtime_error("failed to open file: " + filename);
-        size_t fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-        return buffer;
+    void createReplayTarget() {
+        vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, swapChainImageFormat, 
+            {swapChainExtent.width, swapChainExtent.height, 1}, 1, 1, 
+            vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, 
+            vk::ImageUsageFlagBits::eColorAttachment);
+        replayImage = vk::raii::Image(device, imageInfo);
+
+        vk::MemoryRequirements memReq = replayImage.getMemoryRequirements();
+        vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(physicalDevice, memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+        replayImageMemory = vk::raii::DeviceMemory(device, allocInfo);
+        replayImage.bindMemory(*replayImageMemory, 0);
+
+        vk::ImageViewCreateInfo viewInfo({}, *replayImage, vk::ImageViewType::e2D, swapChainImageFormat, {}, {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1});
+        replayImageView = vk::raii::ImageView(device, viewInfo);
+
+        std::array<vk::ImageView, 3> attachments = {*colorImageView, *depthImageView, *replayImageView};
+        vk::FramebufferCreateInfo fbInfo({}, *renderPass, static_cast<uint32_t>(attachments.size()), attachments.data(), swapChainExtent.width, swapChainExtent.height, 1);
+        replayFramebuffer = vk::raii::Framebuffer(device, fbInfo);
+    }
+
+    uint32_t captureConfigFlags() const {
+        return (options.meshlets ? kCaptureMeshlets : 0) | (options.occlusion ? kCaptureOcclusion : 0);
+    }
+
+    static std::string describeCaptureConfig(uint32_t flags) {
+        if (flags & kCaptureMeshlets) return "--meshlets";
+        if (flags & kCaptureOcclusion) return "--occlusion";
+        return "neither --meshlets nor --occlusion";
+    }
+
+    // The op stream indexes resources that only exist in the configuration it was recorded with
+    void checkCaptureConfig(uint32_t flags) const {
+        if (flags != captureConfigFlags()) {
+            throw std::runtime_error("capture was recorded with " + describeCaptureConfig(flags) + " but replay was started with "
+                + describeCaptureConfig(captureConfigFlags()) + "; pass the same options to --replay!");
+        }
+    }
+
+    void replayCapture(const FrameReplayer& replayer) {
+        std::cout << "Replaying " << replayer.getFrameCount() << " frames from " << options.replayPath << std::endl;
+
+        // GPU timing needs timestamp support on the graphics queue
+        float timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod;
+        uint32_t timestampValidBits = physicalDevice.getQueueFamilyProperties()[graphicsFamilyIndex].timestampValidBits;
+
+        auto stats = replayer.run(device, commandPool, graphicsQueue, captureResources, timestampPeriod, timestampValidBits, options.replayLoops);
+        device.waitIdle();
+
+        std::string reportPath = options.replayPath + ".csv";
+        std::ofstream csv(reportPath);
+        FrameReplayer::report(stats, csv, std::cout);
+        std::cout << "Per-frame timings written to " << reportPath << std::endl;
     }
 
-    vk::raii::ShaderModule createShaderModule(const std::vector<char>& code) {
-        return vk::raii::ShaderModule(device, vk::ShaderModuleCreateInfo({}, code.size(), reinterpret_cast<const uint32_t*>(code.data())));
+    void cleanup() {
+        if (!window) return;
+        glfwDestroyWindow(window);
+        glfwTerminate();
     }
 
+    // --- 6. HELPERS ---
+
     bool checkDeviceExtensionSupport(const vk::raii::PhysicalDevice& dev) {
         auto availableExtensions = dev.enumerateDeviceExtensionProperties();
         std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
@@ -544,36 +1057,18 @@ private:
         return actual;
     }
 
-    uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) {
-        vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
-
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-            if ((typeFilter & (1 << i)) && 
-                (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
-            }
-        }
-        throw std::runtime_error("failed to find suitable memory type!");
-    }
-
-    void createBuffer(vk::DeviceSize size, vk::BufferUsageFlags usage, 
-                    vk::MemoryPropertyFlags properties, 
-                    vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory) {
-        
-        vk::BufferCreateInfo bufferInfo({}, size, usage, vk::SharingMode::eExclusive);
-        buffer = vk::raii::Buffer(device, bufferInfo);
-
-        vk::MemoryRequirements memRequirements = buffer.getMemoryRequirements();
-        vk::MemoryAllocateInfo allocInfo(memRequirements.size, findMemoryType(memRequirements.memoryTypeBits, properties));
-
-        bufferMemory = vk::raii::DeviceMemory(device, allocInfo);
-        buffer.bindMemory(*bufferMemory, 0);
+    // Tallies what reportAttachmentMemory() prints
+    vk::raii::DeviceMemory allocateAttachmentMemory(const vk::MemoryRequirements& memReq, bool transient, bool& lazy) {
+        vk::raii::DeviceMemory memory = ::allocateAttachmentMemory(device, physicalDevice, memReq, transient, lazy);
+        attachmentBytes += memReq.size;
+        if (lazy) lazyAttachmentBytes += memReq.size;
+        return memory;
     }
 
     void createUniformBuffer() {
         vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
 
-        createBuffer(bufferSize, 
+        createBuffer(device, physicalDevice, bufferSize, 
             vk::BufferUsageFlagBits::eUniformBuffer, 
             vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, 
             uniformBuffer, uniformBufferMemory);
@@ -587,20 +1082,13 @@ private:
         float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
         UniformBufferObject ubo{};
+        updateInstanceTransforms(ubo.models, 0, INSTANCE_COUNT, time);
+        updateSceneCamera(ubo, cameraPosition, swapChainExtent);
 
-        for (int i = 0; i < INSTANCE_COUNT; i++) {
-                glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, i * -2.5f, 0.0f));
-                model = glm::rotate(model, time * glm::radians(45.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-                
-                ubo.models[i] = model;
-            }
-
-        ubo.view = glm::lookAt(glm::vec3(5.0f, 5.0f, 5.0f), glm::vec3(0.0f, -10.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-        ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 100.0f);
-        
-        ubo.proj[1][1] *= -1;
+        cameraViewProj = ubo.proj * ubo.view;
 
         memcpy(uniformBufferMapped, &ubo, sizeof(ubo));
+        if (capture) capture->updateUniform(*uniformBuffer, 0, &ubo, sizeof(ubo));
     }
 
     vk::Format findDepthFormat() {
@@ -619,20 +1107,31 @@ private:
         throw std::runtime_error("failed to find supported depth format!");
     }
 
+    bool hasStencilComponent(vk::Format format) {
+        return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
+    }
+
+    vk::ImageSubresourceRange depthSubresourceRange() {
+        vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eDepth;
+        if (hasStencilComponent(depthFormat)) aspect |= vk::ImageAspectFlagBits::eStencil;
+        return vk::ImageSubresourceRange(aspect, 0, 1, 0, 1);
+    }
+
     void createDepthResources() {
         depthFormat = findDepthFormat();
 
-        // 1. Create the Image
+        // 1. Create the Image; the Hi-Z build samples it when occlusion culling is on, otherwise
+        // depth never leaves the pass and can stay transient
+        vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eDepthStencilAttachment;
+        usage |= options.occlusion ? vk::ImageUsageFlagBits::eSampled : vk::ImageUsageFlagBits::eTransientAttachment;
         vk::ImageCreateInfo imageInfo({}, vk::ImageType::e2D, depthFormat, 
             {swapChainExtent.width, swapChainExtent.height, 1}, 1, 1, 
             msaaSamples, vk::ImageTiling::eOptimal, 
-            vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::SharingMode::eExclusive);
+            usage, vk::SharingMode::eExclusive);
         depthImage = vk::raii::Image(device, imageInfo);
 
         // Allocate memory
-        vk::MemoryRequirements memReq = depthImage.getMemoryRequirements();
-        vk::MemoryAllocateInfo allocInfo(memReq.size, findMemoryType(memReq.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
-        depthImageMemory = vk::raii::DeviceMemory(device, allocInfo);
+        depthImageMemory = allocateAttachmentMemory(depthImage.getMemoryRequirements(), !options.occlusion, depthImageLazy);
         depthImage.bindMemory(*depthImageMemory, 0);
 
         // 2. Create the View
@@ -642,8 +1141,53 @@ private:
     }
 };
 
-int main() {
-    HelloTriangleApplication app;
+int main(int argc, char** argv) {
+    AppOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--meshlets") { options.meshlets = true; continue; }
+        if (arg == "--occlusion") { options.occlusion = true; continue; }
+        if (arg == "--dynamic-rendering") { options.dynamicRendering = true; continue; }
+
+        if (i + 1 >= argc) { std::cerr << "missing value for " << arg << std::endl; return EXIT_FAILURE; }
+        std::string value = argv[++i];
+        try {
+            if (arg == "--capture") options.capturePath = value;
+            else if (arg == "--capture-frames") options.captureFrames = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--replay") options.replayPath = value;
+            else if (arg == "--replay-loops") options.replayLoops = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--vt") options.virtualTexturePath = value;
+            else if (arg == "--bake-vt") options.bakeImagePath = value;
+            else { std::cerr << "unknown option: " << arg << std::endl; return EXIT_FAILURE; }
+        } catch (const std::exception&) {
+            std::cerr << "invalid value for " << arg << ": " << value << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.meshlets && options.occlusion) {
+        std::cerr << "--meshlets and --occlusion both replace the scene draw; pick one" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!options.virtualTexturePath.empty() && (!options.capturePath.empty() || !options.replayPath.empty())) {
+        std::cerr << "--vt page uploads are not captured, so replays would not be reproducible; drop --capture/--replay" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.dynamicRendering && (!options.capturePath.empty() || !options.replayPath.empty())) {
+        std::cerr << "--dynamic-rendering has no framebuffers to capture or replay into; drop --capture/--replay" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!options.bakeImagePath.empty()) {
+        try { PageFile::bake(options.bakeImagePath, options.bakeImagePath + ".vtpf"); }
+        catch (const std::exception& e) { std::cerr << e.what() << std::endl; return EXIT_FAILURE; }
+        std::cout << "Baked " << options.bakeImagePath << ".vtpf" << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    HelloTriangleApplication app(std::move(options));
     try { app.run(); } 
     catch (const std::exception& e) { std::cerr << e.what() << std::endl; return EXIT_FAILURE; }
     return EXIT_SUCCESS;
@@ -0,0 +1,20 @@
+// Shared by the virtual texture shaders. Mirrors VirtualTextureParams in VirtualTexture.h.
+layout(push_constant) uniform VirtualTextureParams {
+    vec2 virtualSize;
+    vec2 cacheSize;
+    float pageSize;
+    float border;
+    float maxMip;
+    float feedbackBias;
+} vt;
+
+// Mip level the hardware would pick for a texture of the virtual size
+float vtMipLevel(vec2 uv) {
+    vec2 dx = dFdx(uv * vt.virtualSize);
+    vec2 dy = dFdy(uv * vt.virtualSize);
+    return 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vt.feedbackBias;
+}
+
+vec2 vtPageCount(float mip) {
+    return max(vec2(1.0), floor(vt.virtualSize / exp2(mip) / vt.pageSize));
+}
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "vt_common.glsl"
+
+// Same interface as the vertex stage used by the main pipeline
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out uint outPage;
+
+void main() {
+    vec2 uv = fract(fragTexCoord);
+    uint mip = uint(clamp(floor(vtMipLevel(fragTexCoord)), 0.0, vt.maxMip));
+
+    vec2 pages = vtPageCount(float(mip));
+    uvec2 page = uvec2(min(floor(uv * pages), pages - 1.0));
+
+    // Decoded by VirtualTexture::processFeedback
+    outPage = (mip << 24) | (page.y << 12) | page.x;
+}
@@ -0,0 +1,29 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "vt_common.glsl"
+
+layout(binding = 2) uniform sampler2D indirectionSampler;
+layout(binding = 3) uniform sampler2D cacheSampler;
+
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 uv = fract(fragTexCoord);
+    float mip = clamp(floor(vtMipLevel(fragTexCoord)), 0.0, vt.maxMip);
+
+    // Entry: cache slot (r, g) and the mip that slot actually holds (b), which may be coarser
+    vec4 entry = textureLod(indirectionSampler, uv, mip) * 255.0;
+    vec2 slot = floor(entry.rg + 0.5);
+    float residentMip = floor(entry.b + 0.5);
+
+    vec2 pageCoord = uv * max(vec2(1.0), vt.virtualSize / exp2(residentMip)) / vt.pageSize;
+    vec2 local = pageCoord - floor(min(pageCoord, vtPageCount(residentMip) - 1.0));
+
+    float tileSize = vt.pageSize + 2.0 * vt.border;
+    vec2 texel = slot * tileSize + vt.border + local * vt.pageSize;
+
+    outColor = textureLod(cacheSampler, texel / vt.cacheSize, 0.0);
+}